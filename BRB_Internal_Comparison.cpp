@@ -10,17 +10,34 @@
 #include <sstream>
 #include <map>
 #include <filesystem> // for filename extraction
+#include "WCTE_Output.h"
+#include "WCTE_Progress.h"
+#include "WCTE_FastHist.h"
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <BRB root file>" << std::endl;
+    std::vector<std::string> args;
+    Long64_t max_events = -1;
+    unsigned output_mode = WCTE_Output::kPDF;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else if (arg == "--output-mode" && i + 1 < argc) {
+            if (!WCTE_Output::ParseMode(argv[++i], output_mode)) return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <BRB root file> [--max-events N] [--output-mode root|json|pdf]" << std::endl;
         return 1;
     }
 
-    std::string filepath = argv[1];
+    std::string filepath = args[0];
     std::string filename = std::filesystem::path(filepath).filename().string(); // Only filename
 
-    TFile* fileBRB = TFile::Open(argv[1]);
+    TFile* fileBRB = TFile::Open(filepath.c_str());
     if (!fileBRB || fileBRB->IsZombie()) {
         std::cerr << "Error opening BRB file!" << std::endl;
         return 1;
@@ -75,35 +92,30 @@ int main(int argc, char* argv[]) {
     }
     mappingFile.close();
 
-    Long64_t nEntriesBRB = treeBRB->GetEntries();
-    nEntriesBRB = 5000; // limit for testing
+    Long64_t nEntriesBRB = WCTE_Progress::Limit(treeBRB->GetEntries(), max_events);
 
-    std::vector<TH1D*> hists_brb_qdc(64, nullptr);
-    std::vector<TH1D*> hists_brb_tdc(64, nullptr);
-    std::vector<TH1D*> hists_hit_qdc(64, nullptr);
-    std::vector<TH1D*> hists_hit_tdc(64, nullptr);
-
-    for (int i = 0; i < 64; ++i) {
-        hists_brb_qdc[i] = new TH1D(Form("hBRB_qdc_%d", i), Form("Beamline QDC ID %d", i), 450, 0, 4500);
-        hists_brb_tdc[i] = new TH1D(Form("hBRB_tdc_%d", i), Form("Beamline TDC ID %d", i), 800, 0, 800);
-        hists_hit_qdc[i] = new TH1D(Form("hHIT_qdc_%d", i), Form("HitPMT QDC ID %d", i), 850, 0, 8500);
-        hists_hit_tdc[i] = new TH1D(Form("hHIT_tdc_%d", i), Form("HitPMT TDC ID %d", i), 8000, 0, 8000);
-    }
+    // Counted in FastHists during the loop, converted to TH1Ds for drawing
+    std::vector<FastHist1D> fast_brb_qdc(64, FastHist1D(450, 0, 4500));
+    std::vector<FastHist1D> fast_brb_tdc(64, FastHist1D(800, 0, 800));
+    std::vector<FastHist1D> fast_hit_qdc(64, FastHist1D(850, 0, 8500));
+    std::vector<FastHist1D> fast_hit_tdc(64, FastHist1D(8000, 0, 8000));
 
+    WCTE_Progress progress("BRB", nEntriesBRB);
     for (Long64_t i = 0; i < nEntriesBRB; ++i) {
         treeBRB->GetEntry(i);
+        progress.Add();
 
         if (brb_qdc && brb_qdc_ids) {
             for (size_t j = 0; j < brb_qdc_ids->size(); ++j) {
                 int idx = (*brb_qdc_ids)[j];
-                if (idx >= 0 && idx < 64) hists_brb_qdc[idx]->Fill((*brb_qdc)[j]);
+                if (idx >= 0 && idx < 64) fast_brb_qdc[idx].Fill((*brb_qdc)[j]);
             }
         }
 
         if (brb_tdc && brb_tdc_ids) {
             for (size_t j = 0; j < brb_tdc_ids->size(); ++j) {
                 int idx = (*brb_tdc_ids)[j];
-                if (idx >= 0 && idx < 64) hists_brb_tdc[idx]->Fill((*brb_tdc)[j]);
+                if (idx >= 0 && idx < 64) fast_brb_tdc[idx].Fill((*brb_tdc)[j]);
             }
         }
 
@@ -117,14 +129,47 @@ int main(int argc, char* argv[]) {
                     if (idx >= 0 && idx < 64) {
                         double tdc_value = (*hit_tdc)[j];
                         if (tdc_value >= 2100 && tdc_value <= 2300) {
-                            hists_hit_qdc[idx]->Fill((*hit_qdc)[j]);
+                            fast_hit_qdc[idx].Fill((*hit_qdc)[j]);
                         }
-                        hists_hit_tdc[idx]->Fill(tdc_value);
+                        fast_hit_tdc[idx].Fill(tdc_value);
                     }
                 }
             }
         }
     }
+    progress.Finish();
+
+    std::vector<TH1D*> hists_brb_qdc(64, nullptr);
+    std::vector<TH1D*> hists_brb_tdc(64, nullptr);
+    std::vector<TH1D*> hists_hit_qdc(64, nullptr);
+    std::vector<TH1D*> hists_hit_tdc(64, nullptr);
+
+    for (int i = 0; i < 64; ++i) {
+        hists_brb_qdc[i] = fast_brb_qdc[i].ToTH1D(Form("hBRB_qdc_%d", i), Form("Beamline QDC ID %d", i));
+        hists_brb_tdc[i] = fast_brb_tdc[i].ToTH1D(Form("hBRB_tdc_%d", i), Form("Beamline TDC ID %d", i));
+        hists_hit_qdc[i] = fast_hit_qdc[i].ToTH1D(Form("hHIT_qdc_%d", i), Form("HitPMT QDC ID %d", i));
+        hists_hit_tdc[i] = fast_hit_tdc[i].ToTH1D(Form("hHIT_tdc_%d", i), Form("HitPMT TDC ID %d", i));
+    }
+
+    WCTE_Output output("BRB_Internal_Comparison", output_mode);
+    output.AddMetric("entries_read", nEntriesBRB);
+    for (int i = 0; i < 64; ++i) {
+        output.Add(hists_brb_qdc[i], "beamline");
+        output.Add(hists_brb_tdc[i], "beamline");
+        output.Add(hists_hit_qdc[i], "hitpmt");
+        output.Add(hists_hit_tdc[i], "hitpmt");
+        if (!beamlineidx_to_name.count(i)) continue;
+        const std::string& name = beamlineidx_to_name[i];
+        output.AddMetric(name + "_beamline_qdc_mean", hists_brb_qdc[i]->GetMean());
+        output.AddMetric(name + "_hitpmt_qdc_mean", hists_hit_qdc[i]->GetMean());
+        output.AddMetric(name + "_beamline_tdc_mean", hists_brb_tdc[i]->GetMean());
+        output.AddMetric(name + "_hitpmt_tdc_mean", hists_hit_tdc[i]->GetMean());
+    }
+    if (!output.Write()) return 1;
+    if (!output.Has(WCTE_Output::kPDF)) {
+        fileBRB->Close();
+        return 0;
+    }
 
     TCanvas* c = new TCanvas("c", "Comparison", 1000, 1200);
     c->Print("BRB_Internal_Comparison.pdf(");
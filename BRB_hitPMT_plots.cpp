@@ -6,14 +6,32 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <string>
+#include "WCTE_Output.h"
+#include "WCTE_Progress.h"
+#include "WCTE_FastHist.h"
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <BRB root file>" << std::endl;
+    std::vector<std::string> args;
+    Long64_t max_events = -1;
+    unsigned output_mode = WCTE_Output::kPDF;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else if (arg == "--output-mode" && i + 1 < argc) {
+            if (!WCTE_Output::ParseMode(argv[++i], output_mode)) return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <BRB root file> [--max-events N] [--output-mode root|json|pdf]" << std::endl;
         return 1;
     }
 
-    TFile* fileBRB = TFile::Open(argv[1]);
+    TFile* fileBRB = TFile::Open(args[0].c_str());
     if (!fileBRB || fileBRB->IsZombie()) {
         std::cerr << "Error opening BRB file!" << std::endl;
         return 1;
@@ -36,8 +54,7 @@ int main(int argc, char* argv[]) {
     treeBRB->SetBranchAddress("hit_mpmt_card_ids", &hit_card);
     treeBRB->SetBranchAddress("hit_pmt_channel_ids", &hit_chan);
 
-    Long64_t nEntriesBRB = treeBRB->GetEntries();
-    nEntriesBRB = 5000; // Limit to 5000 entries for testing
+    Long64_t nEntriesBRB = WCTE_Progress::Limit(treeBRB->GetEntries(), max_events);
 
     // Mapping: (card, channel) -> detector name
     std::map<std::pair<int, int>, std::string> id_name_map = {
@@ -56,11 +73,19 @@ int main(int argc, char* argv[]) {
         {{132,17},"T4-L"}, {{132,18},"T4-R"}, {{132,19},"Trigger-132"}
     };
 
+    // Dense per (card 130-132, channel) counters; TH1Ds are made after the loop
+    const int kFirstCard = 130, kCards = 3, kChannels = 20;
+    std::vector<FastHist1D> fast_qdc(kCards * kChannels, FastHist1D(8500, 0, 8500));
+    std::vector<FastHist1D> fast_tdc(kCards * kChannels, FastHist1D(8500, 0, 8500));
+    std::vector<bool> seen(kCards * kChannels, false);
+
     std::map<std::pair<int, int>, TH1D*> hists_qdc;
     std::map<std::pair<int, int>, TH1D*> hists_tdc;
 
+    WCTE_Progress progress("BRB", nEntriesBRB);
     for (Long64_t i = 0; i < nEntriesBRB; ++i) {
         treeBRB->GetEntry(i);
+        progress.Add();
 
         if (!hit_qdc || !hit_tdc || !hit_card || !hit_chan) continue;
 
@@ -69,25 +94,42 @@ int main(int argc, char* argv[]) {
             int chan = (*hit_chan)[j];
 
             if (card != 130 && card != 131 && card != 132) continue; // Only cards 130, 131, 132
+            if (chan < 0 || chan >= kChannels) continue;
 
-            auto key = std::make_pair(card, chan);
-
-            if (!hists_qdc.count(key)) {
-                hists_qdc[key] = new TH1D(Form("hQDC_card%d_chan%d", card, chan), 
-                                          Form("QDC: Card %d Chan %d;QDC;Counts", card, chan),
-                                          8500, 0, 8500);
-            }
-
-            if (!hists_tdc.count(key)) {
-                hists_tdc[key] = new TH1D(Form("hTDC_card%d_chan%d", card, chan), 
-                                          Form("TDC: Card %d Chan %d;TDC (ns);Counts", card, chan),
-                                          8500, 0, 8500);
-            }
-
-            hists_qdc[key]->Fill((*hit_qdc)[j]);
-            hists_tdc[key]->Fill((*hit_tdc)[j]);
+            int slot = (card - kFirstCard) * kChannels + chan;
+            seen[slot] = true;
+            fast_qdc[slot].Fill((*hit_qdc)[j]);
+            fast_tdc[slot].Fill((*hit_tdc)[j]);
         }
     }
+    progress.Finish();
+
+    for (int slot = 0; slot < kCards * kChannels; ++slot) {
+        if (!seen[slot]) continue;
+        int card = kFirstCard + slot / kChannels;
+        int chan = slot % kChannels;
+        auto key = std::make_pair(card, chan);
+        hists_qdc[key] = fast_qdc[slot].ToTH1D(Form("hQDC_card%d_chan%d", card, chan),
+                                               Form("QDC: Card %d Chan %d;QDC;Counts", card, chan));
+        hists_tdc[key] = fast_tdc[slot].ToTH1D(Form("hTDC_card%d_chan%d", card, chan),
+                                               Form("TDC: Card %d Chan %d;TDC (ns);Counts", card, chan));
+    }
+
+    WCTE_Output output("hit_pmt_detector_plots", output_mode);
+    output.AddMetric("entries_read", nEntriesBRB);
+    for (auto& [key, hqdc] : hists_qdc) {
+        std::string dir = Form("card%d", key.first);
+        output.Add(hqdc, dir);
+        output.Add(hists_tdc[key], dir);
+        output.AddMetric(Form("card%d_chan%d_hits", key.first, key.second), hqdc->GetEntries());
+        output.AddMetric(Form("card%d_chan%d_qdc_mean", key.first, key.second), hqdc->GetMean());
+        output.AddMetric(Form("card%d_chan%d_tdc_mean", key.first, key.second), hists_tdc[key]->GetMean());
+    }
+    if (!output.Write()) return 1;
+    if (!output.Has(WCTE_Output::kPDF)) {
+        fileBRB->Close();
+        return 0;
+    }
 
     // Now draw everything
     TCanvas* c = new TCanvas("c", "Hit PMT Distributions", 1000, 1200);
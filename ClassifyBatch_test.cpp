@@ -0,0 +1,133 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "WCTE_BeamMon_PID.h"
+
+// Checks WCTE_BeamMon_PID::ClassifyBatch (AVX2 kernel where the CPU has it)
+// against the scalar box classification, which ClassifyBatch applies to
+// batches shorter than four events, for float and double inputs.
+static int failures = 0;
+
+// Box edges, shared on purpose: electron and muon meet at tof 12 / act 5000
+static const double kBoxes[3][4] = {
+    {11.0, 12.0, 5000.0, 20000.0},  // electron
+    {12.0, 13.0, 0.0, 5000.0},      // muon
+    {13.0, 16.0, 0.0, 3000.0},      // pion
+};
+
+static std::string box(int k) {
+    return "{\"tof_min\":" + std::to_string(kBoxes[k][0]) + ",\"tof_max\":" + std::to_string(kBoxes[k][1]) +
+           ",\"act_min\":" + std::to_string(kBoxes[k][2]) + ",\"act_max\":" + std::to_string(kBoxes[k][3]) + "}";
+}
+
+template <typename T>
+static void check(const WCTE_BeamMon_PID& pid, const std::vector<T>& tof, const std::vector<T>& act,
+                  const char* type) {
+    // Every length and start offset: unaligned loads and scalar tails of 1-3
+    for (size_t begin = 0; begin < 4 && begin <= tof.size(); ++begin) {
+        size_t n = tof.size() - begin;
+        std::vector<int16_t> batch(n, -1);
+        pid.ClassifyBatch(tof.data() + begin, act.data() + begin, n, batch.data());
+        for (size_t i = 0; i < n; ++i) {
+            int16_t scalar = -1;
+            pid.ClassifyBatch(tof.data() + begin + i, act.data() + begin + i, 1, &scalar);
+            if (batch[i] == scalar) continue;
+            std::cerr << "FAIL (" << type << "): tof=" << tof[begin + i] << " act=" << act[begin + i]
+                      << " batch=" << batch[i] << " scalar=" << scalar << std::endl;
+            ++failures;
+        }
+    }
+}
+
+static void expect(const WCTE_BeamMon_PID& pid, double tof, double act, int16_t code) {
+    int16_t out = -1;
+    pid.ClassifyBatch(&tof, &act, 1, &out);
+    if (out == code) return;
+    std::cerr << "FAIL: tof=" << tof << " act=" << act << " gives " << out << ", expected " << code << std::endl;
+    ++failures;
+}
+
+int main() {
+    char dir[] = "/tmp/wcte_classify_test.XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cerr << "Cannot create a temporary directory" << std::endl;
+        return 1;
+    }
+    std::string json_file = std::string(dir) + "/boxcuts.json";
+    std::ofstream out(json_file);
+    out << "{\"1670\": {\"box\": {\"electron\": " << box(0) << ", \"muon\": " << box(1)
+        << ", \"pion\": " << box(2) << "}}}\n";
+    out.close();
+
+    WCTE_BeamMon_PID pid;
+    bool loaded = pid.LoadBoxCuts(json_file);
+    std::remove(json_file.c_str());
+    rmdir(dir);
+    if (!loaded) return 1;
+    pid.SetRunID(1670);
+
+    // Priority and edges of the scalar classification itself
+    expect(pid, 12.0, 5000.0, 11);   // electron and muon edges: electron first
+    expect(pid, 12.5, 5000.0, 13);
+    expect(pid, 13.0, 3000.0, 13);   // muon and pion edges: muon first
+    expect(pid, 15.0, 3000.0, 211);
+    expect(pid, 16.0, 3000.1, 0);
+    expect(pid, -999.0, 1000.0, 0);
+    expect(pid, 12.5, -1.0, 0);
+
+    // Boundary values: every edge, its neighbours, sentinels, NaN and inf
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> tof_values = {-999.0, nan, inf, -inf, 0.0, 10.0, 20.0};
+    std::vector<double> act_values = {-1.0, -0.0, 0.0, nan, inf, -inf, 1e-300, 100000.0};
+    for (int k = 0; k < 3; ++k) {
+        for (int l = 0; l < 2; ++l) {
+            double t = kBoxes[k][l];
+            tof_values.insert(tof_values.end(), {t, std::nextafter(t, -inf), std::nextafter(t, inf),
+                                                 (double)std::nextafter((float)t, -INFINITY),
+                                                 (double)std::nextafter((float)t, INFINITY)});
+            double a = kBoxes[k][2 + l];
+            act_values.insert(act_values.end(), {a, std::nextafter(a, -inf), std::nextafter(a, inf),
+                                                 (double)std::nextafter((float)a, -INFINITY),
+                                                 (double)std::nextafter((float)a, INFINITY)});
+        }
+    }
+
+    // All pairs, then random points around the boxes; neither count is a multiple of 4
+    std::vector<double> tof, act;
+    for (double t : tof_values)
+        for (double a : act_values) {
+            tof.push_back(t);
+            act.push_back(a);
+        }
+    tof.push_back(12.5);
+    act.push_back(2500.0);
+    if (tof.size() % 4 == 0) {
+        tof.push_back(nan);
+        act.push_back(nan);
+    }
+
+    std::mt19937 rng(4357);
+    std::uniform_real_distribution<double> u_tof(10.0, 17.0), u_act(-500.0, 21000.0);
+    for (int i = 0; i < 100003; ++i) {
+        tof.push_back(u_tof(rng));
+        act.push_back(u_act(rng));
+    }
+
+    check(pid, tof, act, "double");
+    std::vector<float> tof_f(tof.begin(), tof.end()), act_f(act.begin(), act.end());
+    check(pid, tof_f, act_f, "float");
+
+    if (failures) {
+        std::cerr << failures << " ClassifyBatch check(s) failed." << std::endl;
+        return 1;
+    }
+    std::cout << "ClassifyBatch: all checks passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "WCTE_Config.h"
+
+// Checks WCTE_Config run lookups on a small boxcuts.json, once parsed from
+// the JSON and once from the binary cache written by the first load.
+static int failures = 0;
+
+static void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    std::cerr << "FAIL: " << what << std::endl;
+    ++failures;
+}
+
+static std::string box(double tof_min) {
+    std::string species;
+    for (const char* s : {"electron", "muon", "pion"}) {
+        if (!species.empty()) species += ",";
+        species += std::string("\"") + s + "\":{\"tof_min\":" + std::to_string(tof_min) +
+                   ",\"tof_max\":20,\"act_min\":0,\"act_max\":5}";
+    }
+    return "{" + species + "}";
+}
+
+static void check(const WCTE_Config& config, const std::string& source) {
+    WCTE_Config::Box b;
+
+    // Range 1600-1699: box and GoodRun true
+    expect(config.FindBox(1650, b) && b.cuts[0][0] == 10, source + ": range box");
+    expect(config.IsGoodRun(1650), source + ": range GoodRun");
+
+    // 1670 only adjusts the box: its own cuts, the range's GoodRun
+    expect(config.FindBox(1670, b) && b.cuts[1][0] == 11, source + ": run box over range box");
+    expect(config.IsGoodRun(1670), source + ": box-only run keeps the range GoodRun");
+
+    // 1680 only sets GoodRun false: the range's box, its own flag
+    expect(config.FindBox(1680, b) && b.cuts[2][0] == 10, source + ": quality-only run keeps the range box");
+    expect(!config.IsGoodRun(1680), source + ": run GoodRun over range GoodRun");
+
+    // 1700: box without data quality, and outside every range
+    expect(config.FindBox(1700, b) && b.cuts[0][0] == 12, source + ": single run box");
+    expect(!config.IsGoodRun(1700), source + ": no GoodRun flag means bad");
+    expect(!config.FindBox(1599, b) && !config.IsGoodRun(1599), source + ": run outside every key");
+
+    int n_boxes = 0;
+    config.ForEachBox([&](int, int, const WCTE_Config::Box&) { ++n_boxes; });
+    expect(n_boxes == 3, source + ": ForEachBox visits the keys with a box");
+}
+
+int main() {
+    char dir[] = "/tmp/wcte_config_test.XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::cerr << "Cannot create a temporary directory" << std::endl;
+        return 1;
+    }
+    std::string json_file = std::string(dir) + "/boxcuts.json";
+    std::string cache_file = WCTE_Config::DefaultCacheFile(json_file);
+
+    std::ofstream out(json_file);
+    out << "{\n"
+        << " \"1600-1699\": {\"box\": " << box(10) << ", \"dataquality\": {\"GoodRun\": true}},\n"
+        << " \"1670\": {\"box\": " << box(11) << "},\n"
+        << " \"1680\": {\"dataquality\": {\"GoodRun\": false}},\n"
+        << " \"1700\": {\"box\": " << box(12) << ", \"dataquality\": {\"comment\": \"no flag\"}}\n"
+        << "}\n";
+    out.close();
+
+    WCTE_Config from_json;
+    expect(from_json.Load(json_file, cache_file) && !from_json.FromCache(), "load from JSON");
+    check(from_json, "json");
+
+    WCTE_Config from_cache;
+    expect(from_cache.Load(json_file, cache_file) && from_cache.FromCache(), "load from cache");
+    check(from_cache, "cache");
+
+    std::remove(cache_file.c_str());
+    std::remove(json_file.c_str());
+    rmdir(dir);
+
+    if (failures) {
+        std::cerr << failures << " Config check(s) failed." << std::endl;
+        return 1;
+    }
+    std::cout << "Config: all checks passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "WCTE_HitIndex.h"
+
+// Checks WCTE_HitIndex against a plain scan of the card ids, over a
+// sequence of events that reuses one index the way WCTE_EventReader does.
+static int failures = 0;
+
+static void check(const WCTE_HitIndex& index, const std::vector<int>& card_ids, const std::string& name) {
+    int max_card = -1;
+    size_t n_indexed = 0;
+    for (int card : card_ids) {
+        if (card < 0) continue;
+        if (card > max_card) max_card = card;
+        ++n_indexed;
+    }
+
+    bool ok = index.MaxCard() == max_card && index.Size() == n_indexed;
+    for (int card = -1; card <= max_card + 1; ++card) {
+        std::vector<int> expected;
+        if (card >= 0)
+            for (size_t j = 0; j < card_ids.size(); ++j)
+                if (card_ids[j] == card) expected.push_back((int)j);
+        WCTE_HitIndex::Range r = index.Card(card);
+        ok = ok && std::vector<int>(r.begin(), r.end()) == expected;
+    }
+
+    if (!ok) {
+        std::cerr << "FAIL: " << name << std::endl;
+        ++failures;
+    }
+}
+
+int main() {
+    const std::vector<std::pair<std::string, std::vector<int>>> events = {
+        {"empty first event", {}},
+        {"only negative card ids", {-1, -5, -1}},
+        {"single card", {3, 3, 3}},
+        {"growing card ids", {0, 131, 7, 131, 2}},
+        {"negative ids mixed in", {-1, 5, -2, 5, 0}},
+        {"empty after hits", {}},
+        {"lower card ids than before", {1, 0, 1}},
+        {"highest card id again", {131}},
+    };
+
+    WCTE_HitIndex index;
+    for (const auto& ev : events) {
+        index.Build(ev.second);
+        check(index, ev.second, ev.first);
+    }
+
+    // A fresh index whose first event has no indexable hit
+    WCTE_HitIndex fresh;
+    fresh.Build(std::vector<int>{-3});
+    check(fresh, {-3}, "fresh index, negative id only");
+
+    index.Clear();
+    if (index.MaxCard() != -1 || index.Size() != 0 || !index.Card(0).empty()) {
+        std::cerr << "FAIL: Clear" << std::endl;
+        ++failures;
+    }
+
+    if (failures) {
+        std::cerr << failures << " HitIndex check(s) failed." << std::endl;
+        return 1;
+    }
+    std::cout << "HitIndex: all checks passed." << std::endl;
+    return 0;
+}
@@ -4,7 +4,9 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <numeric>
 #include "WCTE_Utility.h"
+#include "WCTE_Log.h"
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
@@ -37,7 +39,6 @@ int main(int argc, char* argv[]) {
     // -- Setup utility class
     WCTE_Utility util;
     util.SetHitPMTData(hit_card_ids, hit_channel_ids, hit_times);
-    util.InitializeT0Calibration(tree, 1000);  // or however many events you want
 
     // -- Direct method setup
     const int t0_channels[4] = {12, 13, 14, 15};
@@ -48,6 +49,8 @@ int main(int argc, char* argv[]) {
     Long64_t entries_to_use = std::min(tree->GetEntries(), (Long64_t)1000);
     for (Long64_t i = 0; i < entries_to_use; ++i) {
         tree->GetEntry(i);
+        util.SetHitPMTData(hit_card_ids, hit_channel_ids, hit_times);
+        util.AddCalibrationHits();
         for (size_t j = 0; j < hit_card_ids->size(); ++j) {
             int card = (*hit_card_ids)[j];
             if (card != 131) continue;
@@ -62,6 +65,8 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (!util.FinalizeT0Calibration()) return 1;
+
     for (int i = 0; i < 4; ++i) {
         const auto& v = t0_values[i];
         if (v.empty()) continue;
@@ -97,6 +102,7 @@ int main(int argc, char* argv[]) {
 
         double ref_t0 = t0_sum / 4.0;
 
+        util.SetHitPMTData(hit_card_ids, hit_channel_ids, hit_times);
 
         auto util_t0_opt = util.ComputeEventT0();
 
@@ -108,6 +114,8 @@ int main(int argc, char* argv[]) {
         //}
     }
 
+    WCTE_Log::PrintSummary();
+
     file->Close();
     return 0;
 }
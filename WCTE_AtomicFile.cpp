@@ -0,0 +1,30 @@
+#include "WCTE_AtomicFile.h"
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool WCTE_WriteFileAtomic(const std::string& path, const std::function<void(std::ostream&)>& write) {
+    std::string pattern = path + ".XXXXXX";
+    std::vector<char> tmp(pattern.begin(), pattern.end());
+    tmp.push_back('\0');
+
+    int fd = mkstemp(tmp.data());
+    if (fd < 0) return false;
+    // mkstemp creates the file 0600; caches are shared like any other output
+    mode_t mask = umask(0);
+    umask(mask);
+    fchmod(fd, 0666 & ~mask);
+    close(fd);
+
+    std::ofstream out(tmp.data(), std::ios::binary | std::ios::trunc);
+    if (out.is_open()) write(out);
+    out.close();
+
+    if (!out || std::rename(tmp.data(), path.c_str()) != 0) {
+        std::remove(tmp.data());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,16 @@
+#ifndef WCTE_ATOMICFILE_H
+#define WCTE_ATOMICFILE_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+
+// Writes a binary file through a uniquely named temporary file in the same
+// directory (mkstemp), renamed over path once write() has succeeded. Readers
+// see either the old file or the complete new one, an interrupted job
+// leaves no half file, and parallel jobs writing the same path (e.g. one
+// cache shared by an xargs -P batch) never rename each other's partial
+// output into place. Returns false, removing the temporary, on any error.
+bool WCTE_WriteFileAtomic(const std::string& path, const std::function<void(std::ostream&)>& write);
+
+#endif
@@ -1,21 +1,54 @@
 #include <TFile.h>
 #include <TTree.h>
 #include <TH1D.h>
+#include <TH2D.h>
 #include <TCanvas.h>
 #include <TText.h>
 #include <TSystem.h>
 #include <TString.h>
 #include <iostream>
 #include <vector>
+#include <string>
+#include <cmath>
+#include "WCTE_EventMatch.h"
+#include "WCTE_Log.h"
+#include "WCTE_Output.h"
+#include "WCTE_Progress.h"
+#include "WCTE_VMEReader.h"
 
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <BRB root file> <VME root file>" << std::endl;
+    std::vector<std::string> args;
+    Long64_t max_events = -1;
+    unsigned output_mode = WCTE_Output::kPDF;
+    bool match = false;
+    std::string brb_key = WCTE_EventMatch::kDefaultKeys;
+    std::string vme_key = WCTE_EventMatch::kDefaultKeys;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else if (arg == "--match") {
+            match = true;
+        } else if (arg == "--brb-key" && i + 1 < argc) {
+            brb_key = argv[++i];
+            match = true;
+        } else if (arg == "--vme-key" && i + 1 < argc) {
+            vme_key = argv[++i];
+            match = true;
+        } else if (arg == "--output-mode" && i + 1 < argc) {
+            if (!WCTE_Output::ParseMode(argv[++i], output_mode)) return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " <BRB root file> <VME root file> [--max-events N] [--output-mode root|json|pdf] [--match [--brb-key EXPR] [--vme-key EXPR]]" << std::endl;
         return 1;
     }
 
-    TFile* fileBRB = TFile::Open(argv[1]);
-    TFile* fileVME = TFile::Open(argv[2]);
+    TFile* fileBRB = TFile::Open(args[0].c_str());
+    TFile* fileVME = TFile::Open(args[1].c_str());
 
     if (!fileBRB || !fileVME || fileBRB->IsZombie() || fileVME->IsZombie()) {
         std::cerr << "Error opening files!" << std::endl;
@@ -34,8 +67,6 @@ int main(int argc, char* argv[]) {
     std::vector<int>* brb_qdc_ids = nullptr;
     std::vector<float>* brb_tdc = nullptr;
     std::vector<int>* brb_tdc_ids = nullptr;
-    std::vector<double>* vme_qdc = nullptr;
-    std::vector<std::vector<double>>* vme_tdc = nullptr;
     std::vector<std::string>* vme_id_names = nullptr;
 
     treeBRB->SetBranchAddress("beamline_pmt_qdc_charges", &brb_qdc);
@@ -43,11 +74,11 @@ int main(int argc, char* argv[]) {
     treeBRB->SetBranchAddress("beamline_pmt_tdc_times", &brb_tdc);
     treeBRB->SetBranchAddress("beamline_pmt_tdc_ids", &brb_tdc_ids);
 
-    treeVME->SetBranchAddress("beamline_qdc_charge", &vme_qdc);
-    treeVME->SetBranchAddress("beamline_tdc_time", &vme_tdc);
+    // VME QDC/TDC in the BRB layout, TDC already on the BRB time base
+    WCTE_VMEReader vme(treeVME);
     treeVME->SetBranchAddress("beamline_id_name", &vme_id_names);
 
-    const int nChannels = 64;
+    const int nChannels = WCTE_VMEReader::kChannels;
 
     TH1D* hBRB_QDC_All = new TH1D("hBRB_QDC_All", "BRB QDC All Channels;QDC;Counts", 410, 0, 4500);
     TH1D* hVME_QDC_All = new TH1D("hVME_QDC_All", "VME QDC All Channels;QDC;Counts", 410, 0, 4500);
@@ -79,10 +110,11 @@ int main(int argc, char* argv[]) {
         hists_tdc.push_back(h4);
     }
 
-    Long64_t nEntriesBRB = treeBRB->GetEntries();
-    nEntriesBRB = 5000;
+    Long64_t nEntriesBRB = WCTE_Progress::Limit(treeBRB->GetEntries(), max_events);
+    WCTE_Progress progressBRB("BRB", nEntriesBRB);
     for (Long64_t i = 0; i < nEntriesBRB; ++i) {
         treeBRB->GetEntry(i);
+        progressBRB.Add();
         if (brb_qdc && brb_qdc_ids) {
             for (size_t idx = 0; idx < brb_qdc_ids->size(); ++idx) {
                 int ch = (*brb_qdc_ids)[idx];
@@ -103,28 +135,91 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    Long64_t nEntriesVME = treeVME->GetEntries();
-    nEntriesVME = 5000;
+    progressBRB.Finish();
+
+    Long64_t nEntriesVME = WCTE_Progress::Limit(treeVME->GetEntries(), max_events);
+    WCTE_Progress progressVME("VME", nEntriesVME);
     for (Long64_t i = 0; i < nEntriesVME; ++i) {
-        treeVME->GetEntry(i);
-        if (vme_qdc) {
-            for (int ch = 0; ch < nChannels; ++ch) {
-                if (ch < vme_qdc->size()) {
-                    hists_qdc[ch*2+1]->Fill((*vme_qdc)[ch]);
-                    hVME_QDC_All->Fill((*vme_qdc)[ch]);
+        vme.GetEntry(i);
+        progressVME.Add();
+        for (size_t idx = 0; idx < vme.qdc_ids.size(); ++idx) {
+            hists_qdc[vme.qdc_ids[idx]*2+1]->Fill(vme.qdc_charges[idx]);
+            hVME_QDC_All->Fill(vme.qdc_charges[idx]);
+        }
+        for (size_t idx = 0; idx < vme.tdc_ids.size(); ++idx) {
+            hists_tdc[vme.tdc_ids[idx]*2+1]->Fill(vme.tdc_times[idx]);
+            hVME_TDC_All->Fill(vme.tdc_times[idx]);
+        }
+    }
+
+    progressVME.Finish();
+
+    // Event-matched residuals: index VME by key once, then stream BRB entries
+    // and read the VME entry with the same key
+    TH2D* hQDC_Residual = nullptr;
+    TH2D* hTDC_Residual = nullptr;
+    std::vector<TH1D*> hists_qdc_res, hists_tdc_res;
+    Long64_t n_matched = 0;
+    if (match) {
+        WCTE_EventMatch matcher;
+        if (!matcher.Build(treeVME, vme_key, nEntriesVME) || !matcher.SetProbe(treeBRB, brb_key)) return 1;
+        std::cout << "Indexed " << matcher.Size() << " VME entries by '" << vme_key << "'" << std::endl;
+
+        hQDC_Residual = new TH2D("hQDC_Residual", "QDC BRB - VME (matched events);Channel;#DeltaQDC", nChannels, -0.5, nChannels - 0.5, 400, -1000, 1000);
+        hTDC_Residual = new TH2D("hTDC_Residual", "TDC BRB - VME (matched events);Channel;#DeltaTDC (ns)", nChannels, -0.5, nChannels - 0.5, 400, -50, 50);
+        hQDC_Residual->SetDirectory(0);
+        hTDC_Residual->SetDirectory(0);
+        for (int ch = 0; ch < nChannels; ++ch) {
+            hists_qdc_res.push_back(new TH1D(Form("hQDC_res_ch%d", ch), Form("QDC BRB - VME Channel %d;#DeltaQDC;Events", ch), 400, -1000, 1000));
+            hists_tdc_res.push_back(new TH1D(Form("hTDC_res_ch%d", ch), Form("TDC BRB - VME Channel %d;#DeltaTDC (ns);Events", ch), 400, -50, 50));
+            hists_qdc_res.back()->SetDirectory(0);
+            hists_tdc_res.back()->SetDirectory(0);
+        }
+
+        // First hit per channel of the event; NaN when the channel has none
+        std::vector<double> brb_q(nChannels), brb_t(nChannels);
+        WCTE_Progress progressMatch("Match", nEntriesBRB);
+        for (Long64_t i = 0; i < nEntriesBRB; ++i) {
+            progressMatch.Add();
+            Long64_t j = matcher.Find(i);
+            if (j < 0) continue;
+            treeBRB->GetEntry(i);
+            vme.GetEntry(j);
+            ++n_matched;
+
+            std::fill(brb_q.begin(), brb_q.end(), NAN);
+            std::fill(brb_t.begin(), brb_t.end(), NAN);
+            if (brb_qdc && brb_qdc_ids) {
+                for (size_t idx = 0; idx < brb_qdc_ids->size(); ++idx) {
+                    int ch = (*brb_qdc_ids)[idx];
+                    if (ch >= 0 && ch < nChannels && std::isnan(brb_q[ch])) brb_q[ch] = (*brb_qdc)[idx];
                 }
             }
-        }
-        if (vme_tdc) {
-            for (int ch = 0; ch < nChannels; ++ch) {
-                if (ch < vme_tdc->size()) {
-                    for (double val : (*vme_tdc)[ch]) {
-                        hists_tdc[ch*2+1]->Fill(val + 250.0);
-                        hVME_TDC_All->Fill(val + 250.0);
-                    }
+            if (brb_tdc && brb_tdc_ids) {
+                for (size_t idx = 0; idx < brb_tdc_ids->size(); ++idx) {
+                    int ch = (*brb_tdc_ids)[idx];
+                    if (ch >= 0 && ch < nChannels && std::isnan(brb_t[ch])) brb_t[ch] = (*brb_tdc)[idx];
                 }
             }
+
+            for (size_t idx = 0; idx < vme.qdc_ids.size(); ++idx) {
+                int ch = vme.qdc_ids[idx];
+                if (std::isnan(brb_q[ch])) continue;
+                double d = brb_q[ch] - vme.qdc_charges[idx];
+                hists_qdc_res[ch]->Fill(d);
+                hQDC_Residual->Fill(ch, d);
+            }
+            for (int ch = 0; ch < nChannels; ++ch) {
+                WCTE_VMEReader::Range hits = vme.TDC(ch);
+                if (hits.empty() || std::isnan(brb_t[ch])) continue;
+                double d = brb_t[ch] - *hits.begin();
+                hists_tdc_res[ch]->Fill(d);
+                hTDC_Residual->Fill(ch, d);
+            }
         }
+        progressMatch.Finish();
+        std::cout << "Matched " << n_matched << " of " << nEntriesBRB << " BRB entries" << std::endl;
+        WCTE_Log::PrintSummary();
     }
 
     std::vector<std::string> id_names;
@@ -133,6 +228,39 @@ int main(int argc, char* argv[]) {
         for (auto& name : *vme_id_names) id_names.push_back(name);
     }
 
+    WCTE_Output output("comparison_report", output_mode);
+    output.AddMetric("brb_entries_read", nEntriesBRB);
+    output.AddMetric("vme_entries_read", nEntriesVME);
+    for (TH1D* h : {hBRB_QDC_All, hVME_QDC_All, hBRB_TDC_All, hVME_TDC_All}) output.Add(h);
+    for (int ch = 0; ch < nChannels; ++ch) {
+        std::string dir = Form("ch%d", ch);
+        output.Add(hists_qdc[ch*2], dir);
+        output.Add(hists_qdc[ch*2+1], dir);
+        output.Add(hists_tdc[ch*2], dir);
+        output.Add(hists_tdc[ch*2+1], dir);
+        output.AddMetric(Form("ch%d_qdc_mean_diff", ch), hists_qdc[ch*2]->GetMean() - hists_qdc[ch*2+1]->GetMean());
+        output.AddMetric(Form("ch%d_tdc_mean_diff", ch), hists_tdc[ch*2]->GetMean() - hists_tdc[ch*2+1]->GetMean());
+    }
+    if (match) {
+        output.AddMetric("matched_events", n_matched);
+        output.Add(hQDC_Residual);
+        output.Add(hTDC_Residual);
+        for (int ch = 0; ch < nChannels; ++ch) {
+            output.Add(hists_qdc_res[ch], "residuals");
+            output.Add(hists_tdc_res[ch], "residuals");
+            output.AddMetric(Form("ch%d_qdc_residual_mean", ch), hists_qdc_res[ch]->GetMean());
+            output.AddMetric(Form("ch%d_qdc_residual_rms", ch), hists_qdc_res[ch]->GetRMS());
+            output.AddMetric(Form("ch%d_tdc_residual_mean", ch), hists_tdc_res[ch]->GetMean());
+            output.AddMetric(Form("ch%d_tdc_residual_rms", ch), hists_tdc_res[ch]->GetRMS());
+        }
+    }
+    if (!output.Write()) return 1;
+    if (!output.Has(WCTE_Output::kPDF)) {
+        fileBRB->Close();
+        fileVME->Close();
+        return 0;
+    }
+
     TCanvas* cTitle = new TCanvas("cTitle", "Title Page", 800, 600);
     cTitle->Print("comparison_report.pdf(");
     cTitle->cd();
@@ -141,8 +269,8 @@ int main(int argc, char* argv[]) {
     title->SetTextSize(0.04);
     title->Draw();
 
-    TString file1(argv[1]);
-    TString file2(argv[2]);
+    TString file1(args[0].c_str());
+    TString file2(args[1].c_str());
     file1 = gSystem->BaseName(file1);
     file2 = gSystem->BaseName(file2);
 
@@ -208,6 +336,29 @@ int main(int argc, char* argv[]) {
         delete c;
     }
 
+    if (match) {
+        TCanvas* cSec3 = new TCanvas("cSec3", "Section 3", 800, 600);
+        TText* sec3 = new TText(0.5, 0.5, Form("Event-matched residuals BRB - VME (%lld events)", n_matched));
+        sec3->SetTextAlign(22);
+        sec3->SetTextSize(0.03);
+        sec3->Draw();
+        cSec3->Print("comparison_report.pdf");
+
+        TCanvas* cRes = new TCanvas("cRes", "Residuals", 1000, 800);
+        cRes->Divide(1,2);
+        cRes->cd(1); hQDC_Residual->Draw("colz");
+        cRes->cd(2); hTDC_Residual->Draw("colz");
+        cRes->Print("comparison_report.pdf");
+
+        // Per-channel pages only for channels present in both readouts
+        for (int ch = 0; ch < nChannels; ++ch) {
+            if (hists_qdc_res[ch]->GetEntries() == 0 && hists_tdc_res[ch]->GetEntries() == 0) continue;
+            cRes->cd(1); hists_qdc_res[ch]->Draw();
+            cRes->cd(2); hists_tdc_res[ch]->Draw();
+            cRes->Print("comparison_report.pdf");
+        }
+    }
+
     TCanvas* cEnd = new TCanvas("cEnd", "End", 800, 600);
     cEnd->Print("comparison_report.pdf)");
 
@@ -10,15 +10,51 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <string>
+#include "WCTE_BeamMon_PID.h"
+#include "WCTE_ChannelMap.h"
+#include "WCTE_EventMatch.h"
+#include "WCTE_Log.h"
+#include "WCTE_Output.h"
+#include "WCTE_Progress.h"
+#include "WCTE_VMEReader.h"
 
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <BRB root file> <VME root file>" << std::endl;
+    std::vector<std::string> args;
+    Long64_t max_events = -1;
+    unsigned output_mode = WCTE_Output::kPDF;
+    bool match = false;
+    std::string brb_key = WCTE_EventMatch::kDefaultKeys;
+    std::string vme_key = WCTE_EventMatch::kDefaultKeys;
+    std::string mapping_file;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else if (arg == "--match") {
+            match = true;
+        } else if (arg == "--brb-key" && i + 1 < argc) {
+            brb_key = argv[++i];
+            match = true;
+        } else if (arg == "--vme-key" && i + 1 < argc) {
+            vme_key = argv[++i];
+            match = true;
+        } else if (arg == "--mapping" && i + 1 < argc) {
+            mapping_file = argv[++i];
+        } else if (arg == "--output-mode" && i + 1 < argc) {
+            if (!WCTE_Output::ParseMode(argv[++i], output_mode)) return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " <BRB root file> <VME root file> [--max-events N] [--output-mode root|json|pdf] [--match [--brb-key EXPR] [--vme-key EXPR]] [--mapping <detector_mapping.txt>]" << std::endl;
         return 1;
     }
 
-    TFile* fileBRB = TFile::Open(argv[1]);
-    TFile* fileVME = TFile::Open(argv[2]);
+    TFile* fileBRB = TFile::Open(args[0].c_str());
+    TFile* fileVME = TFile::Open(args[1].c_str());
 
     if (!fileBRB || !fileVME || fileBRB->IsZombie() || fileVME->IsZombie()) {
         std::cerr << "Error opening files!" << std::endl;
@@ -42,14 +78,13 @@ int main(int argc, char* argv[]) {
     treeBRB->SetBranchAddress("beamline_pmt_tdc_times", &brb_tdc);
     treeBRB->SetBranchAddress("beamline_pmt_tdc_ids", &brb_tdc_ids);
 
-    std::vector<double>* vme_qdc = nullptr;
-    std::vector<std::vector<double>>* vme_tdc = nullptr;
-    treeVME->SetBranchAddress("beamline_qdc_charge", &vme_qdc);
-    treeVME->SetBranchAddress("beamline_tdc_time", &vme_tdc);
+    WCTE_VMEReader vme(treeVME);
 
-    const int nChannels = 64;
-    Long64_t nEntriesBRB = std::min(treeBRB->GetEntries(), (Long64_t)5000);
-    Long64_t nEntriesVME = std::min(treeVME->GetEntries(), (Long64_t)5000);
+    // Beamline channel roles (T0, T1, ACT3-5, ...) come from the mapping file
+    WCTE_BeamMon_PID pid;
+    if (!pid.SetupChannelMap(mapping_file)) return 1;
+    Long64_t nEntriesBRB = WCTE_Progress::Limit(treeBRB->GetEntries(), max_events);
+    Long64_t nEntriesVME = WCTE_Progress::Limit(treeVME->GetEntries(), max_events);
 
     TH1D* h_brb_tof_t0t1 = new TH1D("h_brb_tof_t0t1", "BRB TOF T1-T0;T1-T0 (ns);Counts", 100, 10, 20);
     TH1D* h_vme_tof_t0t1 = new TH1D("h_vme_tof_t0t1", "VME TOF T1-T0;T1-T0 (ns);Counts", 100, 10, 20);
@@ -58,68 +93,131 @@ int main(int argc, char* argv[]) {
     TH2D* h_brb_act_group2_sum_tof_t0t1 = new TH2D("h_brb_act_group2_sum_tof_t0t1", "BRB ACT3-5 Sum vs TOF;T1-T0 (ns);Charge", 100, 10, 20, 900, 0, 18000);
     TH2D* h_vme_act_group2_sum_tof_t0t1 = new TH2D("h_vme_act_group2_sum_tof_t0t1", "VME ACT3-5 Sum vs TOF;T1-T0 (ns);Charge", 100, 10, 20, 900, 0, 18000);
 
+    WCTE_Progress progressBRB("BRB", nEntriesBRB);
     for (Long64_t i = 0; i < nEntriesBRB; ++i) {
         treeBRB->GetEntry(i);
+        progressBRB.Add();
+        pid.SetBeamlineData(brb_qdc, brb_qdc_ids, brb_tdc, brb_tdc_ids);
 
-        double t0 = 0, t1 = 0;
-        int t0hits = 0, t1hits = 0;
-        bool t4_hit = false;
-        bool hole0 = false, hole1 = false;
-        double act_sum = 0;
-
-        for (size_t j = 0; brb_qdc_ids && j < brb_qdc_ids->size(); ++j) {
-            int ch = (*brb_qdc_ids)[j];
-            float qdc = (*brb_qdc)[j];
-            if (ch == 42 || ch == 43) if (qdc > 300) t4_hit = true;
-            if (ch == 9 && qdc > 150) hole0 = true;
-            if (ch == 10 && qdc > 100) hole1 = true;
-            if (ch >= 18 && ch <= 23) act_sum += qdc;
-        }
-
-        if (!t4_hit || hole0 || hole1) continue;
-
-        for (size_t j = 0; brb_tdc_ids && j < brb_tdc_ids->size(); ++j) {
-            int ch = (*brb_tdc_ids)[j];
-            float tdc = (*brb_tdc)[j] - 250;
-            if (ch >= 0 && ch <= 3 && tdc < -100) { t0 += tdc; ++t0hits; }
-            if (ch >= 4 && ch <= 7 && tdc < -100) { t1 += tdc; ++t1hits; }
-        }
-
-        if (t0hits == 4 && t1hits == 4) {
-            double tof = (t1 / 4.0) - (t0 / 4.0);
+        if (pid.EventPassesCuts()) {
+            double tof = pid.GetTofT0T1();
+            double act_sum = pid.GetActGroup2Sum();
             h_brb_tof_t0t1->Fill(tof);
             h_brb_act_group2_sum->Fill(act_sum);
             h_brb_act_group2_sum_tof_t0t1->Fill(tof, act_sum);
         }
     }
 
-    for (Long64_t i = 0; i < nEntriesVME; ++i) {
-        treeVME->GetEntry(i);
+    progressBRB.Finish();
 
+    // ana_calib-style VME selection: four T0 and four T1 hits below -100 ns,
+    // with the channel roles of the PID code but on the reader's double
+    // precision view, so no hit near the cut moves across it
+    const WCTE_ChannelMap& channel_map = pid.GetChannelMap();
+    auto selectVME = [&](double& tof, double& act_sum) {
         double t0 = 0, t1 = 0;
         int t0hits = 0, t1hits = 0;
-        double act_sum = 0;
-
-        for (int ch = 0; ch < 64 && vme_tdc && ch < vme_tdc->size(); ++ch) {
-            for (double val : (*vme_tdc)[ch]) {
-                if (ch >= 0 && ch <= 3 && val < -100) { t0 += val; ++t0hits; }
-                if (ch >= 4 && ch <= 7 && val < -100) { t1 += val; ++t1hits; }
+        for (int ch = 0; ch < WCTE_VMEReader::kChannels; ++ch) {
+            uint8_t role = channel_map.GetRole(ch);
+            if (role != WCTE_ChannelMap::kT0 && role != WCTE_ChannelMap::kT1) continue;
+            for (double val : vme.RawTDC(ch)) {
+                if (!(val < -100)) continue;
+                if (role == WCTE_ChannelMap::kT0) { t0 += val; ++t0hits; }
+                else { t1 += val; ++t1hits; }
             }
         }
+        if (t0hits != 4 || t1hits != 4) return false;
+        tof = (t1 / 4.0) - (t0 / 4.0);
 
-        if (t0hits == 4 && t1hits == 4) {
-            double tof = (t1 / 4.0) - (t0 / 4.0);
-            h_vme_tof_t0t1->Fill(tof);
+        act_sum = 0;
+        for (size_t idx = 0; idx < vme.qdc_ids.size(); ++idx) {
+            if (channel_map.GetRole(vme.qdc_ids[idx]) == WCTE_ChannelMap::kACTGroup2) act_sum += vme.qdc_raw[idx];
+        }
+        return true;
+    };
 
-            if (vme_qdc) {
-                for (int ch = 18; ch <= 23 && ch < vme_qdc->size(); ++ch) {
-                    act_sum += (*vme_qdc)[ch];
-                }
-            }
+    WCTE_Progress progressVME("VME", nEntriesVME);
+    for (Long64_t i = 0; i < nEntriesVME; ++i) {
+        vme.GetEntry(i);
+        progressVME.Add();
+
+        double tof, act_sum;
+        if (selectVME(tof, act_sum)) {
+            h_vme_tof_t0t1->Fill(tof);
             h_vme_act_group2_sum->Fill(act_sum);
             h_vme_act_group2_sum_tof_t0t1->Fill(tof, act_sum);
         }
     }
+    progressVME.Finish();
+
+    // Events matched by key and selected in both readouts: per-event differences
+    TH1D* h_tof_residual = nullptr;
+    TH1D* h_act_residual = nullptr;
+    TH2D* h_tof_brb_vs_vme = nullptr;
+    Long64_t n_matched = 0, n_both = 0;
+    if (match) {
+        WCTE_EventMatch matcher;
+        if (!matcher.Build(treeVME, vme_key, nEntriesVME) || !matcher.SetProbe(treeBRB, brb_key)) return 1;
+        std::cout << "Indexed " << matcher.Size() << " VME entries by '" << vme_key << "'" << std::endl;
+
+        h_tof_residual = new TH1D("h_tof_residual", "TOF BRB - VME (matched events);#DeltaTOF (ns);Events", 200, -2, 2);
+        h_act_residual = new TH1D("h_act_residual", "ACT3-5 Sum BRB - VME (matched events);#DeltaCharge;Events", 400, -4000, 4000);
+        h_tof_brb_vs_vme = new TH2D("h_tof_brb_vs_vme", "TOF BRB vs VME (matched events);VME T1-T0 (ns);BRB T1-T0 (ns)", 100, 10, 20, 100, 10, 20);
+
+        WCTE_Progress progressMatch("Match", nEntriesBRB);
+        for (Long64_t i = 0; i < nEntriesBRB; ++i) {
+            progressMatch.Add();
+            Long64_t j = matcher.Find(i);
+            if (j < 0) continue;
+            ++n_matched;
+
+            treeBRB->GetEntry(i);
+            pid.SetBeamlineData(brb_qdc, brb_qdc_ids, brb_tdc, brb_tdc_ids);
+            if (!pid.EventPassesCuts()) continue;
+            vme.GetEntry(j);
+            double vme_tof, vme_act;
+            if (!selectVME(vme_tof, vme_act)) continue;
+
+            ++n_both;
+            double brb_tof = pid.GetTofT0T1();
+            h_tof_residual->Fill(brb_tof - vme_tof);
+            h_act_residual->Fill(pid.GetActGroup2Sum() - vme_act);
+            h_tof_brb_vs_vme->Fill(vme_tof, brb_tof);
+        }
+        progressMatch.Finish();
+        std::cout << "Matched " << n_matched << " of " << nEntriesBRB << " BRB entries, "
+                  << n_both << " selected in both" << std::endl;
+        WCTE_Log::PrintSummary();
+    }
+
+    WCTE_Output output("EvSelPlots_comparison_report", output_mode);
+    output.AddMetric("brb_entries_read", nEntriesBRB);
+    output.AddMetric("vme_entries_read", nEntriesVME);
+    output.AddMetric("brb_events_selected", h_brb_tof_t0t1->GetEntries());
+    output.AddMetric("vme_events_selected", h_vme_tof_t0t1->GetEntries());
+    output.AddMetric("brb_tof_mean", h_brb_tof_t0t1->GetMean());
+    output.AddMetric("vme_tof_mean", h_vme_tof_t0t1->GetMean());
+    output.AddMetric("brb_act_group2_sum_mean", h_brb_act_group2_sum->GetMean());
+    output.AddMetric("vme_act_group2_sum_mean", h_vme_act_group2_sum->GetMean());
+    for (TH1* h : {(TH1*)h_brb_tof_t0t1, (TH1*)h_vme_tof_t0t1, (TH1*)h_brb_act_group2_sum, (TH1*)h_vme_act_group2_sum,
+                   (TH1*)h_brb_act_group2_sum_tof_t0t1, (TH1*)h_vme_act_group2_sum_tof_t0t1})
+        output.Add(h);
+    if (match) {
+        output.AddMetric("matched_events", n_matched);
+        output.AddMetric("matched_selected_both", n_both);
+        output.AddMetric("tof_residual_mean", h_tof_residual->GetMean());
+        output.AddMetric("tof_residual_rms", h_tof_residual->GetRMS());
+        output.AddMetric("act_residual_mean", h_act_residual->GetMean());
+        output.AddMetric("act_residual_rms", h_act_residual->GetRMS());
+        output.Add(h_tof_residual);
+        output.Add(h_act_residual);
+        output.Add(h_tof_brb_vs_vme);
+    }
+    if (!output.Write()) return 1;
+    if (!output.Has(WCTE_Output::kPDF)) {
+        fileBRB->Close(); fileVME->Close();
+        return 0;
+    }
 
     TCanvas* c = new TCanvas("cPID", "PID Comparison", 1200, 800);
     c->Print("comparison_report.pdf(");
@@ -152,6 +250,17 @@ int main(int argc, char* argv[]) {
         c->Print("EvSelPlots_comparison_report.pdf");
     }
 
+    if (match) {
+        c->Clear(); c->Divide(1,2);
+        c->cd(1); h_tof_residual->Draw();
+        c->cd(2); h_act_residual->Draw();
+        c->Print("EvSelPlots_comparison_report.pdf");
+
+        c->Clear();
+        h_tof_brb_vs_vme->Draw("colz");
+        c->Print("EvSelPlots_comparison_report.pdf");
+    }
+
     c->Print("EvSelPlots_comparison_report.pdf)");
     fileBRB->Close(); fileVME->Close();
     return 0;
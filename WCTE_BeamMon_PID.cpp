@@ -1,15 +1,112 @@
 #include "WCTE_BeamMon_PID.h"
-#include <fstream>
 #include <iostream>
-#include <nlohmann/json.hpp>
-#include <stdexcept>
 
-using json = nlohmann::json;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WCTE_PID_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Box limits are passed flattened as b[k] = {tof_min, tof_max, act_min, act_max}
+// with k = 0, 1, 2 for electron, muon, pion.
+const int16_t kBoxCodes[3] = {11, 13, 211};
+
+inline int16_t classifyBox(const double (&b)[3][4], double tof, double act) {
+    if (tof == -999 || act < 0) return 0;
+    for (int k = 0; k < 3; ++k) {
+        if (tof >= b[k][0] && tof <= b[k][1] &&
+            act >= b[k][2] && act <= b[k][3]) {
+            return kBoxCodes[k];
+        }
+    }
+    return 0;
+}
+
+template <typename T>
+void classifyBatchScalar(const double (&b)[3][4], const T* tof, const T* act,
+                         size_t begin, size_t n, int16_t* out) {
+    for (size_t i = begin; i < n; ++i) out[i] = classifyBox(b, tof[i], act[i]);
+}
+
+#ifdef WCTE_PID_AVX2
+// Four events per step in double precision. Codes are blended from the
+// lowest-priority box (pion) up to electron, matching the scalar order.
+// Ordered compares are false for NaN, unordered ones true, as in scalar code.
+__attribute__((target("avx2")))
+inline void classify4(const double (&b)[3][4], __m256d tof, __m256d act, int16_t* out) {
+    __m256d valid = _mm256_and_pd(_mm256_cmp_pd(tof, _mm256_set1_pd(-999.0), _CMP_NEQ_UQ),
+                                  _mm256_cmp_pd(act, _mm256_setzero_pd(), _CMP_NLT_UQ));
+    __m256d codes = _mm256_setzero_pd();
+    for (int k = 2; k >= 0; --k) {
+        __m256d in = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(tof, _mm256_set1_pd(b[k][0]), _CMP_GE_OQ),
+                          _mm256_cmp_pd(tof, _mm256_set1_pd(b[k][1]), _CMP_LE_OQ)),
+            _mm256_and_pd(_mm256_cmp_pd(act, _mm256_set1_pd(b[k][2]), _CMP_GE_OQ),
+                          _mm256_cmp_pd(act, _mm256_set1_pd(b[k][3]), _CMP_LE_OQ)));
+        codes = _mm256_blendv_pd(codes, _mm256_set1_pd(kBoxCodes[k]), in);
+    }
+    codes = _mm256_and_pd(codes, valid);
+    __m128i c32 = _mm256_cvttpd_epi32(codes);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(c32, c32));
+}
+
+__attribute__((target("avx2")))
+size_t classifyBatchAVX2(const double (&b)[3][4], const double* tof, const double* act,
+                         size_t n, int16_t* out) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        classify4(b, _mm256_loadu_pd(tof + i), _mm256_loadu_pd(act + i), out + i);
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t classifyBatchAVX2(const double (&b)[3][4], const float* tof, const float* act,
+                         size_t n, int16_t* out) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        classify4(b, _mm256_cvtps_pd(_mm_loadu_ps(tof + i)),
+                     _mm256_cvtps_pd(_mm_loadu_ps(act + i)), out + i);
+    return i;
+}
+
+bool cpuHasAVX2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#endif
+
+template <typename T>
+void classifyBatch(const double (&b)[3][4], bool has_boxes,
+                   const T* tof, const T* act, size_t n, int16_t* out) {
+    if (!has_boxes) {
+        for (size_t i = 0; i < n; ++i) out[i] = 0;
+        return;
+    }
+    size_t done = 0;
+#ifdef WCTE_PID_AVX2
+    if (cpuHasAVX2()) done = classifyBatchAVX2(b, tof, act, n, out);
+#endif
+    classifyBatchScalar(b, tof, act, done, n, out);
+}
+
+} // namespace
 
 WCTE_BeamMon_PID::WCTE_BeamMon_PID() {}
 
+// Resolves the run's cuts into active_boxes_ once, so the per-event path
+// does no lookups. Calling it again with the same run is free.
 void WCTE_BeamMon_PID::SetRunID(int run_id) {
+    if (run_id == current_run_id_ && cuts_resolved_) return;
     current_run_id_ = run_id;
+    cuts_resolved_ = true;
+
+    WCTE_Config::Box box;
+    has_active_boxes_ = config_ && config_->FindBox(run_id, box);
+    if (!has_active_boxes_) return;
+
+    for (int k = 0; k < 3; ++k)
+        for (int l = 0; l < 4; ++l) active_boxes_[k][l] = box.cuts[k][l];
 }
 
 void WCTE_BeamMon_PID::SetBeamlineData(const std::vector<float>* qdc_charge,
@@ -20,167 +117,111 @@ void WCTE_BeamMon_PID::SetBeamlineData(const std::vector<float>* qdc_charge,
     qdc_ids_    = qdc_ids;
     tdc_time_   = tdc_time;
     tdc_ids_    = tdc_ids;
+    computeSummary();
 }
 
-bool WCTE_BeamMon_PID::LoadBoxCuts(const std::string& json_filename) {
-    std::ifstream file(json_filename);
-    if (!file.is_open()) {
-        std::cerr << "Error opening boxcuts file: " << json_filename << std::endl;
-        return false;
-    }
-
-    json j;
-    file >> j;
-
-    for (auto& [runid_str, rundata] : j.items()) {
-        int run_id = std::stoi(runid_str);
-        BoxDefinitions def;
-        def.electron.t0t1_min = rundata["box"]["electron"]["tof_min"];
-        def.electron.t0t1_max = rundata["box"]["electron"]["tof_max"];
-        def.electron.act_min  = rundata["box"]["electron"]["act_min"];
-        def.electron.act_max  = rundata["box"]["electron"]["act_max"];
-
-        def.muon.t0t1_min = rundata["box"]["muon"]["tof_min"];
-        def.muon.t0t1_max = rundata["box"]["muon"]["tof_max"];
-        def.muon.act_min  = rundata["box"]["muon"]["act_min"];
-        def.muon.act_max  = rundata["box"]["muon"]["act_max"];
-
-        def.pion.t0t1_min = rundata["box"]["pion"]["tof_min"];
-        def.pion.t0t1_max = rundata["box"]["pion"]["tof_max"];
-        def.pion.act_min  = rundata["box"]["pion"]["act_min"];
-        def.pion.act_max  = rundata["box"]["pion"]["act_max"];
-
-        run_boxcuts_[run_id] = def;
-    }
+bool WCTE_BeamMon_PID::LoadBoxCuts(const std::string& json_filename, const std::string& cache_file) {
+    auto config = std::make_shared<WCTE_Config>();
+    if (!config->Load(json_filename, cache_file)) return false;
+    SetConfig(config);
     return true;
 }
 
-bool WCTE_BeamMon_PID::EventPassesCuts() const {
-    if (!qdc_charge_ || !qdc_ids_ || !tdc_time_ || !tdc_ids_) return false;
-
-    double t0 = 0, t1 = 0;
-    int t0hits = 0, t1hits = 0;
-    bool t4_hit = false;
-    bool hole0 = false, hole1 = false;
-    double act_sum = 0;
-
-    // Process QDC information
-    for (size_t j = 0; j < qdc_ids_->size(); ++j) {
-        int ch = (*qdc_ids_)[j];
-        float qdc = (*qdc_charge_)[j];
-        if (ch == 42 || ch == 43) if (qdc > 300) t4_hit = true;
-        if (ch == 9 && qdc > 150) hole0 = true;
-        if (ch == 10 && qdc > 100) hole1 = true;
-        if (ch >= 18 && ch <= 23) act_sum += qdc;
-    }
-
-    if (!t4_hit || hole0 || hole1) return false;
-
-    // Process TDC information
-    for (size_t j = 0; j < tdc_ids_->size(); ++j) {
-        int ch = (*tdc_ids_)[j];
-        float tdc = (*tdc_time_)[j] - 250.0;  // Subtract 250 ns baseline
-        if (ch >= 0 && ch <= 3 && tdc < -100) { t0 += tdc; ++t0hits; }
-        if (ch >= 4 && ch <= 7 && tdc < -100) { t1 += tdc; ++t1hits; }
-    }
-
-    return (t0hits == 4 && t1hits == 4);
+void WCTE_BeamMon_PID::SetConfig(std::shared_ptr<const WCTE_Config> config) {
+    config_ = std::move(config);
+    // Re-resolve in case SetRunID() was called before loading
+    cuts_resolved_ = false;
+    SetRunID(current_run_id_);
 }
 
-double WCTE_BeamMon_PID::computeT0Avg() const {
-    double t0 = 0;
-    int t0hits = 0;
-
-    if (!tdc_time_ || !tdc_ids_) return -999;
-
-    for (size_t j = 0; j < tdc_ids_->size(); ++j) {
-        int ch = (*tdc_ids_)[j];
-        float tdc = (*tdc_time_)[j] - 250.0;
-        if (ch >= 0 && ch <= 3 && tdc < -100) {
-            t0 += tdc;
-            ++t0hits;
+// Single pass over the QDC and TDC vectors of the current event
+void WCTE_BeamMon_PID::computeSummary() {
+    BeamlineSummary sum;
+    sum.has_qdc = qdc_charge_ && qdc_ids_;
+    sum.has_tdc = tdc_time_ && tdc_ids_;
+
+    if (sum.has_qdc) {
+        for (size_t j = 0; j < qdc_ids_->size(); ++j) {
+            float qdc = (*qdc_charge_)[j];
+            switch (channel_map_.GetRole((*qdc_ids_)[j])) {
+                case WCTE_ChannelMap::kT4:        if (qdc > 300) sum.t4_hit = true; break;
+                case WCTE_ChannelMap::kHole0:     if (qdc > 150) sum.hole0 = true; break;
+                case WCTE_ChannelMap::kHole1:     if (qdc > 100) sum.hole1 = true; break;
+                case WCTE_ChannelMap::kACTGroup2: sum.act_sum += qdc; break;
+                default: break;
+            }
         }
     }
 
-    return (t0hits == 4) ? t0 / 4.0 : -999;
-}
-
-double WCTE_BeamMon_PID::computeT1Avg() const {
-    double t1 = 0;
-    int t1hits = 0;
-
-    if (!tdc_time_ || !tdc_ids_) return -999;
-
-    for (size_t j = 0; j < tdc_ids_->size(); ++j) {
-        int ch = (*tdc_ids_)[j];
-        float tdc = (*tdc_time_)[j] - 250.0;
-        if (ch >= 4 && ch <= 7 && tdc < -100) {
-            t1 += tdc;
-            ++t1hits;
+    if (sum.has_tdc) {
+        for (size_t j = 0; j < tdc_ids_->size(); ++j) {
+            float tdc = (*tdc_time_)[j] - 250.0;  // Subtract 250 ns baseline
+            if (!(tdc < -100)) continue;
+            switch (channel_map_.GetRole((*tdc_ids_)[j])) {
+                case WCTE_ChannelMap::kT0: sum.t0_sum += tdc; ++sum.t0_hits; break;
+                case WCTE_ChannelMap::kT1: sum.t1_sum += tdc; ++sum.t1_hits; break;
+                default: break;
+            }
         }
+        if (sum.t0_hits == 4) sum.t0_avg = sum.t0_sum / 4.0;
+        if (sum.t1_hits == 4) sum.t1_avg = sum.t1_sum / 4.0;
     }
 
-    return (t1hits == 4) ? t1 / 4.0 : -999;
+    if (sum.t0_avg != -999 && sum.t1_avg != -999) sum.tof = sum.t1_avg - sum.t0_avg;
+
+    sum.passes_cuts = sum.has_qdc && sum.has_tdc &&
+                      sum.t4_hit && !sum.hole0 && !sum.hole1 &&
+                      sum.t0_hits == 4 && sum.t1_hits == 4;
+
+    summary_ = sum;
 }
 
-double WCTE_BeamMon_PID::computeActGroup2Sum() const {
-    if (!qdc_charge_ || !qdc_ids_) return -1;
+bool WCTE_BeamMon_PID::LoadChannelMap(const std::string& mapping_filename) {
+    return channel_map_.Load(mapping_filename);
+}
 
-    double sum = 0;
-    for (size_t j = 0; j < qdc_ids_->size(); ++j) {
-        int ch = (*qdc_ids_)[j];
-        float val = (*qdc_charge_)[j];
-        if (ch >= 18 && ch <= 23) sum += val;
+bool WCTE_BeamMon_PID::SetupChannelMap(const std::string& mapping_filename) {
+    if (!mapping_filename.empty()) return LoadChannelMap(mapping_filename);
+    if (!LoadChannelMap(kDefaultChannelMap)) {
+        std::cerr << "Using built-in beamline channel roles." << std::endl;
     }
-    return sum;
+    return true;
+}
+
+bool WCTE_BeamMon_PID::EventPassesCuts() const {
+    return summary_.passes_cuts;
 }
 
 double WCTE_BeamMon_PID::GetTofT0T1() const {
-    double t0 = computeT0Avg();
-    double t1 = computeT1Avg();
-    return (t0 != -999 && t1 != -999) ? (t1 - t0) : -999;
+    return summary_.tof;
 }
 
 double WCTE_BeamMon_PID::GetActGroup2Sum() const {
-    return computeActGroup2Sum();
+    return summary_.has_qdc ? summary_.act_sum : -1;
 }
 
 int WCTE_BeamMon_PID::GetParticleIDBox() const {
-    if (!EventPassesCuts()) return 0;
-
-    double tof = GetTofT0T1();
-    double act = GetActGroup2Sum();
-    if (tof == -999 || act < 0) return 0;
-    if (!run_boxcuts_.count(current_run_id_)) return 0;
-
-    const BoxDefinitions& cuts = run_boxcuts_.at(current_run_id_);
-
-    if (tof >= cuts.electron.t0t1_min && tof <= cuts.electron.t0t1_max &&
-        act >= cuts.electron.act_min && act <= cuts.electron.act_max) {
-        return 11; // electron
-    }
-    if (tof >= cuts.muon.t0t1_min && tof <= cuts.muon.t0t1_max &&
-        act >= cuts.muon.act_min && act <= cuts.muon.act_max) {
-        return 13; // muon
-    }
-    if (tof >= cuts.pion.t0t1_min && tof <= cuts.pion.t0t1_max &&
-        act >= cuts.pion.act_min && act <= cuts.pion.act_max) {
-        return 211; // pion
-    }
-
-    return 0;
+    if (!EventPassesCuts() || !has_active_boxes_) return 0;
+    return classifyBox(active_boxes_, GetTofT0T1(), GetActGroup2Sum());
 }
 
+void WCTE_BeamMon_PID::ClassifyBatch(const float* tof, const float* act, size_t n, int16_t* pid_out) const {
+    classifyBatch(active_boxes_, has_active_boxes_, tof, act, n, pid_out);
+}
 
-void WCTE_BeamMon_PID::SetPIDMethod(const std::string& method) {
-    pid_method_ = method;
+void WCTE_BeamMon_PID::ClassifyBatch(const double* tof, const double* act, size_t n, int16_t* pid_out) const {
+    classifyBatch(active_boxes_, has_active_boxes_, tof, act, n, pid_out);
 }
 
-int WCTE_BeamMon_PID::GetParticleID() const {
-    if (pid_method_ == "box") {
-        return GetParticleIDBox();
+bool WCTE_BeamMon_PID::SetPIDMethod(const std::string& method) {
+    if (method == "box") {
+        pid_method_ = PIDMethod::kBox;
+        return true;
     }
-    std::cerr << "Unknown PID method: " << pid_method_ << std::endl;
-    return 0;
+    std::cerr << "Unknown PID method: " << method << std::endl;
+    return false;
 }
 
+int WCTE_BeamMon_PID::GetParticleID() const {
+    return WithPIDMethod([this](auto method) { return GetParticleID(method); });
+}
@@ -3,10 +3,35 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "WCTE_ChannelMap.h"
+#include "WCTE_Config.h"
 
 class WCTE_BeamMon_PID {
 public:
+    // Per-event beamline quantities, filled by one pass over each vector
+    // in SetBeamlineData(). All getters read from this cache.
+    struct BeamlineSummary {
+        bool has_qdc = false;      // QDC vectors were provided
+        bool has_tdc = false;      // TDC vectors were provided
+        double t0_sum = 0, t1_sum = 0;
+        int t0_hits = 0, t1_hits = 0;
+        double t0_avg = -999, t1_avg = -999;
+        double tof = -999;         // T1 - T0, -999 if either average is missing
+        double act_sum = 0;        // ACT3-5 QDC sum
+        bool t4_hit = false;
+        bool hole0 = false, hole1 = false;
+        bool passes_cuts = false;  // T4 hit, no hole counter, 4+4 T0/T1 hits
+    };
+
+    // PID methods. The string from the configuration is resolved once in
+    // SetPIDMethod(); each method also has a tag type so event loops can be
+    // compiled per method through WithPIDMethod().
+    enum class PIDMethod { kBox };
+    struct PIDMethodBox { static constexpr PIDMethod kMethod = PIDMethod::kBox; };
+
     WCTE_BeamMon_PID();
 
     void SetRunID(int run_id);
@@ -15,40 +40,70 @@ public:
                          const std::vector<float>* tdc_time,
                          const std::vector<int>*   tdc_ids);
 
-    bool LoadBoxCuts(const std::string& json_filename);
-    void SetPIDMethod(const std::string& method);
-    
+    // Loads a private WCTE_Config; cache_file as in WCTE_Config::Load()
+    bool LoadBoxCuts(const std::string& json_filename, const std::string& cache_file = "");
+    // Uses a configuration already loaded for the job (e.g. shared with WCTE_DataQuality)
+    void SetConfig(std::shared_ptr<const WCTE_Config> config);
+    const WCTE_Config* GetConfig() const { return config_.get(); }
+    bool LoadChannelMap(const std::string& mapping_filename);
+    // Channel roles for a tool's --mapping option: a file given by name must
+    // load; with an empty name kDefaultChannelMap in the working directory is
+    // tried and the built-in roles are kept when it is missing
+    static constexpr const char* kDefaultChannelMap = "detector_mapping.txt";
+    bool SetupChannelMap(const std::string& mapping_filename);
+    bool SetPIDMethod(const std::string& method);
+    PIDMethod GetPIDMethod() const { return pid_method_; }
+
     double GetTofT0T1() const;
     double GetActGroup2Sum() const;
     int GetParticleID() const;      // Dispatching function
+    int GetParticleID(PIDMethodBox) const { return GetParticleIDBox(); }
     int GetParticleIDBox() const;   // Box cut logic
     bool EventPassesCuts() const;
 
-private:
-    struct ParticleCuts {
-        double t0t1_min, t0t1_max;
-        double act_min, act_max;
-    };
+    // Box classification of n events at once from cached per-event TOF and
+    // ACT3-5 values (structure of arrays). Events that failed
+    // EventPassesCuts() must carry tof = -999. Gives the same codes as
+    // GetParticleIDBox() for the same values; uses AVX2 when available.
+    void ClassifyBatch(const float* tof, const float* act, size_t n, int16_t* pid_out) const;
+    void ClassifyBatch(const double* tof, const double* act, size_t n, int16_t* pid_out) const;
 
-    struct BoxDefinitions {
-        ParticleCuts electron;
-        ParticleCuts muon;
-        ParticleCuts pion;
-    };
+    // Calls f with the tag of the configured method, e.g.
+    //   pid.WithPIDMethod([&](auto method) { for (...) pid.GetParticleID(method); });
+    // so the loop body is instantiated per method with no per-event dispatch.
+    template <class F>
+    decltype(auto) WithPIDMethod(F&& f) const {
+        switch (pid_method_) {
+            case PIDMethod::kBox:
+            default:
+                return f(PIDMethodBox{});
+        }
+    }
+
+    const BeamlineSummary& GetBeamlineSummary() const { return summary_; }
+    const WCTE_ChannelMap& GetChannelMap() const { return channel_map_; }
 
+private:
     int current_run_id_ = -1;
-    std::string pid_method_ = "box";  // Default
+    PIDMethod pid_method_ = PIDMethod::kBox;  // Default
 
-    std::map<int, BoxDefinitions> run_boxcuts_;
+    std::shared_ptr<const WCTE_Config> config_;  // Box cuts per run ID / range
+
+    // Cuts of current_run_id_, rows {tof_min, tof_max, act_min, act_max}
+    // for electron, muon, pion
+    double active_boxes_[3][4] = {};
+    bool has_active_boxes_ = false;
+    bool cuts_resolved_ = false;
+    WCTE_ChannelMap channel_map_;
 
     const std::vector<float>* qdc_charge_ = nullptr;
     const std::vector<int>*   qdc_ids_    = nullptr;
     const std::vector<float>* tdc_time_   = nullptr;
     const std::vector<int>*   tdc_ids_    = nullptr;
 
-    double computeT0Avg() const;
-    double computeT1Avg() const;
-    double computeActGroup2Sum() const;
+    BeamlineSummary summary_;
+
+    void computeSummary();
 };
 
 #endif
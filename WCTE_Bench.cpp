@@ -0,0 +1,352 @@
+// WCTE_Bench.cpp
+//
+// Microbenchmarks for the beamline PID and T0 kernels on synthetic events.
+// Needs no data files: events are generated in memory, cuts come from
+// boxcuts.json. Run with `make bench`.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include "WCTE_BeamMon_PID.h"
+#include "WCTE_Utility.h"
+#include "WCTE_HitIndex.h"
+#include "WCTE_FastHist.h"
+
+namespace {
+
+struct BeamlineEvent {
+    std::vector<float> qdc;
+    std::vector<int>   qdc_ids;
+    std::vector<float> tdc;
+    std::vector<int>   tdc_ids;
+};
+
+struct HitEvent {
+    std::vector<int>    card_ids;
+    std::vector<int>    channel_ids;
+    std::vector<double> times;
+};
+
+// Beamline window shaped like BRB data: every QDC channel read out, T0/T1
+// hits (raw = value + 250) plus a few noise TDC hits, T4 firing in most
+// events. ToF and ACT3-5 spread over the three boxes.
+BeamlineEvent makeBeamlineEvent(std::mt19937& rng) {
+    std::uniform_real_distribution<float> u(0, 1);
+    BeamlineEvent ev;
+
+    float tof = 12.5f + 4.0f * u(rng);
+    float act_each = 3000.0f * u(rng);
+    for (int ch = 0; ch < 64; ++ch) {
+        float q = 50 + 100 * u(rng);
+        if (ch >= 18 && ch <= 23) q = act_each * (0.8f + 0.4f * u(rng));
+        if (ch == 42 || ch == 43) q = (u(rng) < 0.9f) ? 500 + 500 * u(rng) : 100;
+        if (ch == 9 || ch == 10) q = (u(rng) < 0.05f) ? 400 : 20;
+        ev.qdc_ids.push_back(ch);
+        ev.qdc.push_back(q);
+    }
+
+    float t0 = 100 + 20 * u(rng);
+    for (int ch = 0; ch < 8; ++ch) {
+        if (u(rng) < 0.03f) continue;  // occasional missing hit
+        float t = t0 + (ch >= 4 ? tof : 0) + 0.3f * u(rng);
+        ev.tdc_ids.push_back(ch);
+        ev.tdc.push_back(t);
+    }
+    int n_noise = rng() % 16;
+    for (int k = 0; k < n_noise; ++k) {
+        ev.tdc_ids.push_back(8 + rng() % 56);
+        ev.tdc.push_back(400 * u(rng));
+    }
+    return ev;
+}
+
+// Hit PMT window: n_hits spread over the mPMT cards, plus the four T0
+// reference hits on card 131 channels 12-15 near 2200 ns (within 2 sigma,
+// so ComputeEventT0 accepts them)
+HitEvent makeHitEvent(std::mt19937& rng, int n_hits) {
+    std::uniform_real_distribution<double> u(0, 1);
+    std::normal_distribution<double> t0(2200, 2);
+    HitEvent ev;
+
+    for (int k = 0; k < n_hits; ++k) {
+        ev.card_ids.push_back(rng() % 130);
+        ev.channel_ids.push_back(rng() % 19);
+        ev.times.push_back(1000 + 4000 * u(rng));
+    }
+    for (int ch = 12; ch <= 15; ++ch) {
+        double t;
+        do { t = t0(rng); } while (std::abs(t - 2200) > 4);
+        size_t pos = rng() % (ev.card_ids.size() + 1);
+        ev.card_ids.insert(ev.card_ids.begin() + pos, 131);
+        ev.channel_ids.insert(ev.channel_ids.begin() + pos, ch);
+        ev.times.insert(ev.times.begin() + pos, t);
+    }
+    return ev;
+}
+
+// Pre-fusion kernels: one scan of the vectors per quantity, as
+// EventPassesCuts / computeT0Avg / computeT1Avg / computeActGroup2Sum did
+bool legacyPassesCuts(const BeamlineEvent& ev) {
+    double t0 = 0, t1 = 0;
+    int t0hits = 0, t1hits = 0;
+    bool t4_hit = false, hole0 = false, hole1 = false;
+    double act_sum = 0;
+
+    for (size_t j = 0; j < ev.qdc_ids.size(); ++j) {
+        int ch = ev.qdc_ids[j];
+        float qdc = ev.qdc[j];
+        if (ch == 42 || ch == 43) if (qdc > 300) t4_hit = true;
+        if (ch == 9 && qdc > 150) hole0 = true;
+        if (ch == 10 && qdc > 100) hole1 = true;
+        if (ch >= 18 && ch <= 23) act_sum += qdc;
+    }
+    if (!t4_hit || hole0 || hole1) return false;
+
+    for (size_t j = 0; j < ev.tdc_ids.size(); ++j) {
+        int ch = ev.tdc_ids[j];
+        float tdc = ev.tdc[j] - 250.0;
+        if (ch >= 0 && ch <= 3 && tdc < -100) { t0 += tdc; ++t0hits; }
+        if (ch >= 4 && ch <= 7 && tdc < -100) { t1 += tdc; ++t1hits; }
+    }
+    return (t0hits == 4 && t1hits == 4);
+}
+
+double legacyTAvg(const BeamlineEvent& ev, int first_ch) {
+    double sum = 0;
+    int hits = 0;
+    for (size_t j = 0; j < ev.tdc_ids.size(); ++j) {
+        int ch = ev.tdc_ids[j];
+        float tdc = ev.tdc[j] - 250.0;
+        if (ch >= first_ch && ch <= first_ch + 3 && tdc < -100) { sum += tdc; ++hits; }
+    }
+    return (hits == 4) ? sum / 4.0 : -999;
+}
+
+double legacyActSum(const BeamlineEvent& ev) {
+    double sum = 0;
+    for (size_t j = 0; j < ev.qdc_ids.size(); ++j) {
+        int ch = ev.qdc_ids[j];
+        if (ch >= 18 && ch <= 23) sum += ev.qdc[j];
+    }
+    return sum;
+}
+
+// T0 average with a fixed window, as the tools computed it inline
+double inlineEventT0(const HitEvent& ev, const double* mean, const double* sigma) {
+    const int t0_ch[4] = {12, 13, 14, 15};
+    double sum = 0;
+    int hits = 0;
+    for (size_t j = 0; j < ev.card_ids.size(); ++j) {
+        if (ev.card_ids[j] != 131) continue;
+        for (int k = 0; k < 4; ++k) {
+            if (ev.channel_ids[j] == t0_ch[k] && std::abs(ev.times[j] - mean[k]) < 3 * sigma[k]) {
+                sum += ev.times[j];
+                ++hits;
+            }
+        }
+    }
+    return hits == 4 ? sum / 4.0 : -999;
+}
+
+// Runs body(i) for n_events events, best of n_reps, and prints one line
+template <class F>
+void bench(const char* name, long n_events, int n_reps, F&& body) {
+    double best = 1e300;
+    for (int r = 0; r < n_reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (s < best) best = s;
+    }
+    std::printf("  %-34s %9.1f ns/event %12.3g events/s\n", name, 1e9 * best / n_events, n_events / best);
+}
+
+volatile double g_sink;  // keeps results alive
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long n_events = 2000000;
+    int n_reps = 5;
+    int n_hits = 200;
+    std::string boxcutfile = "boxcuts.json";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--events" && i + 1 < argc) {
+            n_events = std::stol(argv[++i]);
+        } else if (arg == "--reps" && i + 1 < argc) {
+            n_reps = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--hits" && i + 1 < argc) {
+            n_hits = std::stoi(argv[++i]);
+        } else if (arg[0] != '-') {
+            boxcutfile = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [boxcuts.json] [--events N] [--reps R] [--hits H]" << std::endl;
+            return 1;
+        }
+    }
+
+    WCTE_BeamMon_PID pid;
+    if (!pid.LoadBoxCuts(boxcutfile)) return 1;
+    pid.SetRunID(1670);
+    pid.SetPIDMethod("box");
+
+    // A pool of distinct events, cycled through so the data does not sit in L1
+    const size_t pool = 16384;
+    std::mt19937 rng(12345);
+    std::vector<BeamlineEvent> beamline(pool);
+    std::vector<HitEvent> hits(pool);
+    for (size_t i = 0; i < pool; ++i) {
+        beamline[i] = makeBeamlineEvent(rng);
+        hits[i] = makeHitEvent(rng, n_hits);
+    }
+
+    std::printf("%ld events per measurement, best of %d, %d PMT hits per window\n\n", n_events, n_reps, n_hits);
+    std::printf("Beamline PID\n");
+
+    bench("legacy EventPassesCuts", n_events, n_reps, [&] {
+        long n = 0;
+        for (long i = 0; i < n_events; ++i) n += legacyPassesCuts(beamline[i % pool]);
+        g_sink = n;
+    });
+    bench("legacy T0/T1 avg + ACT sum", n_events, n_reps, [&] {
+        double s = 0;
+        for (long i = 0; i < n_events; ++i) {
+            const BeamlineEvent& ev = beamline[i % pool];
+            s += legacyTAvg(ev, 0) + legacyTAvg(ev, 4) + legacyActSum(ev);
+        }
+        g_sink = s;
+    });
+    bench("legacy full PID (5 scans)", n_events, n_reps, [&] {
+        double s = 0;
+        for (long i = 0; i < n_events; ++i) {
+            const BeamlineEvent& ev = beamline[i % pool];
+            if (!legacyPassesCuts(ev)) continue;
+            double t0 = legacyTAvg(ev, 0), t1 = legacyTAvg(ev, 4);
+            double tof = (t0 != -999 && t1 != -999) ? t1 - t0 : -999;
+            s += tof + legacyActSum(ev);
+        }
+        g_sink = s;
+    });
+    bench("fused SetBeamlineData", n_events, n_reps, [&] {
+        double s = 0;
+        for (long i = 0; i < n_events; ++i) {
+            const BeamlineEvent& ev = beamline[i % pool];
+            pid.SetBeamlineData(&ev.qdc, &ev.qdc_ids, &ev.tdc, &ev.tdc_ids);
+            s += pid.GetTofT0T1();
+        }
+        g_sink = s;
+    });
+    bench("fused SetBeamlineData + PID", n_events, n_reps, [&] {
+        long s = 0;
+        pid.WithPIDMethod([&](auto method) {
+            for (long i = 0; i < n_events; ++i) {
+                const BeamlineEvent& ev = beamline[i % pool];
+                pid.SetBeamlineData(&ev.qdc, &ev.qdc_ids, &ev.tdc, &ev.tdc_ids);
+                s += pid.GetParticleID(method);
+            }
+        });
+        g_sink = s;
+    });
+
+    // Batched classification of cached TOF/ACT columns
+    std::vector<double> tof_d(pool), act_d(pool);
+    std::vector<float> tof_f(pool), act_f(pool);
+    for (size_t i = 0; i < pool; ++i) {
+        const BeamlineEvent& ev = beamline[i];
+        pid.SetBeamlineData(&ev.qdc, &ev.qdc_ids, &ev.tdc, &ev.tdc_ids);
+        tof_d[i] = pid.EventPassesCuts() ? pid.GetTofT0T1() : -999;
+        act_d[i] = pid.GetActGroup2Sum();
+        tof_f[i] = tof_d[i];
+        act_f[i] = act_d[i];
+    }
+    std::vector<int16_t> codes(pool);
+    bench("batched ClassifyBatch (double)", n_events, n_reps, [&] {
+        long s = 0;
+        for (long done = 0; done < n_events; done += pool) {
+            size_t n = std::min<long>(pool, n_events - done);
+            pid.ClassifyBatch(tof_d.data(), act_d.data(), n, codes.data());
+            s += codes[n - 1];
+        }
+        g_sink = s;
+    });
+    bench("batched ClassifyBatch (float)", n_events, n_reps, [&] {
+        long s = 0;
+        for (long done = 0; done < n_events; done += pool) {
+            size_t n = std::min<long>(pool, n_events - done);
+            pid.ClassifyBatch(tof_f.data(), act_f.data(), n, codes.data());
+            s += codes[n - 1];
+        }
+        g_sink = s;
+    });
+
+    // T0 calibration streams over the synthetic windows
+    std::printf("\nHit PMT T0\n");
+    WCTE_Utility util;
+    for (size_t i = 0; i < pool && !util.IsCalibrated(); ++i) {
+        util.SetHitPMTData(&hits[i].card_ids, &hits[i].channel_ids, &hits[i].times);
+        util.AddCalibrationHits();
+    }
+    if (!util.FinalizeT0Calibration()) return 1;
+
+    const double mean[4] = {2200, 2200, 2200, 2200}, sigma[4] = {2, 2, 2, 2};
+    bench("inline 4-channel T0 loop", n_events, n_reps, [&] {
+        double s = 0;
+        for (long i = 0; i < n_events; ++i) s += inlineEventT0(hits[i % pool], mean, sigma);
+        g_sink = s;
+    });
+    bench("WCTE_Utility::ComputeEventT0", n_events, n_reps, [&] {
+        double s = 0;
+        for (long i = 0; i < n_events; ++i) {
+            const HitEvent& ev = hits[i % pool];
+            util.SetHitPMTData(&ev.card_ids, &ev.channel_ids, &ev.times);
+            s += util.ComputeEventT0().value_or(-999);
+        }
+        g_sink = s;
+    });
+
+    // The index is built once per event and shared by every per-card
+    // consumer, so the first bench is its cost and the second the lookup
+    WCTE_HitIndex index;
+    bench("WCTE_HitIndex::Build", n_events, n_reps, [&] {
+        double s = 0;
+        for (long i = 0; i < n_events; ++i) {
+            index.Build(hits[i % pool].card_ids);
+            s += index.Size();
+        }
+        g_sink = s;
+    });
+    std::vector<WCTE_HitIndex> indexes(pool);
+    for (size_t i = 0; i < pool; ++i) indexes[i].Build(hits[i].card_ids);
+    bench("ComputeEventT0 with hit index", n_events, n_reps, [&] {
+        double s = 0;
+        for (long i = 0; i < n_events; ++i) {
+            const HitEvent& ev = hits[i % pool];
+            util.SetHitPMTData(&ev.card_ids, &ev.channel_ids, &ev.times, &indexes[i % pool]);
+            s += util.ComputeEventT0().value_or(-999);
+        }
+        g_sink = s;
+    });
+
+    // Per-hit histogram fills, as in the per-card hit time plots of TPMT
+    std::printf("\nHit time histograms (per hit)\n");
+    TH1D::AddDirectory(false);
+    TH1D h_root("bench_h_root", "", 5000, 0, 5000);
+    bench("TH1D::Fill", n_events, n_reps, [&] {
+        for (long i = 0; i < n_events; ++i)
+            for (double t : hits[i % pool].times) h_root.Fill(t);
+    });
+    FastHist1D h_fast(5000, 0, 5000);
+    bench("FastHist1D::Fill", n_events, n_reps, [&] {
+        for (long i = 0; i < n_events; ++i)
+            for (double t : hits[i % pool].times) h_fast.Fill(t);
+        g_sink = h_fast.GetBinContent(2200);
+    });
+
+    return 0;
+}
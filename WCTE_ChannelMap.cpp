@@ -0,0 +1,56 @@
+#include "WCTE_ChannelMap.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+WCTE_ChannelMap::WCTE_ChannelMap() {
+    for (int ch = 0; ch < kMaxChannels; ++ch) roles_[ch] = kNone;
+    for (int ch = 0; ch <= 3; ++ch)   roles_[ch] = kT0;
+    for (int ch = 4; ch <= 7; ++ch)   roles_[ch] = kT1;
+    for (int ch = 18; ch <= 23; ++ch) roles_[ch] = kACTGroup2;
+    roles_[9]  = kHole0;
+    roles_[10] = kHole1;
+    roles_[42] = kT4;
+    roles_[43] = kT4;
+}
+
+uint8_t WCTE_ChannelMap::RoleFromName(const std::string& name) {
+    auto starts = [&](const char* prefix) { return name.rfind(prefix, 0) == 0; };
+
+    if (starts("T0-")) return kT0;
+    if (starts("T1-")) return kT1;
+    if (starts("T4-")) return kT4;
+    if (starts("ACT3-") || starts("ACT4-") || starts("ACT5-")) return kACTGroup2;
+    if (name == "HC-0") return kHole0;
+    if (name == "HC-1") return kHole1;
+    return kNone;
+}
+
+// Format: detector_name,card,channel,beamline_index (one header line)
+bool WCTE_ChannelMap::Load(const std::string& mapping_file) {
+    std::ifstream file(mapping_file);
+    if (!file.is_open()) {
+        std::cerr << "Error opening channel mapping file: " << mapping_file << std::endl;
+        return false;
+    }
+
+    uint8_t roles[kMaxChannels] = {kNone};
+    std::string line;
+    std::getline(file, line); // skip header
+
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string name;
+        int card, chan, idx;
+        char comma;
+        std::getline(iss, name, ',');
+        if (!(iss >> card >> comma >> chan >> comma >> idx)) continue;
+        if (idx < 0 || idx >= kMaxChannels) continue;
+
+        uint8_t role = RoleFromName(name);
+        if (role != kNone) roles[idx] = role;
+    }
+
+    for (int ch = 0; ch < kMaxChannels; ++ch) roles_[ch] = roles[ch];
+    return true;
+}
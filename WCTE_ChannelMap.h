@@ -0,0 +1,38 @@
+#ifndef WCTE_CHANNELMAP_H
+#define WCTE_CHANNELMAP_H
+
+#include <cstdint>
+#include <string>
+
+// Dense beamline channel -> role table.
+// Built from detector_mapping.txt by detector name, so a re-cabled run only
+// needs a new mapping file. The default table matches the current cabling.
+class WCTE_ChannelMap {
+public:
+    enum Role : uint8_t {
+        kNone = 0,
+        kT0,         // T0-0L, T0-0R, T0-1L, T0-1R
+        kT1,         // T1-0L, T1-0R, T1-1L, T1-1R
+        kACTGroup2,  // ACT3-5 left/right
+        kHole0,      // HC-0
+        kHole1,      // HC-1
+        kT4          // T4-L, T4-R
+    };
+
+    static constexpr int kMaxChannels = 64;
+
+    WCTE_ChannelMap();
+
+    bool Load(const std::string& mapping_file);
+
+    uint8_t GetRole(int ch) const {
+        return static_cast<unsigned>(ch) < kMaxChannels ? roles_[ch] : static_cast<uint8_t>(kNone);
+    }
+
+    static uint8_t RoleFromName(const std::string& name);
+
+private:
+    uint8_t roles_[kMaxChannels];
+};
+
+#endif
@@ -0,0 +1,259 @@
+#include "WCTE_Config.h"
+#include "WCTE_AtomicFile.h"
+#include "WCTE_RunIndex.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+const char kMagic[8] = {'W', 'C', 'T', 'E', 'C', 'F', 'G', 'C'};
+const uint32_t kVersion = 2;
+
+const char* kSpecies[3] = {"electron", "muon", "pion"};
+const char* kLimits[4] = {"tof_min", "tof_max", "act_min", "act_max"};
+
+// Same rule as WCTE_RunIndex::Find: a single run wins over a range
+template <typename R>
+const R* findRecord(const R* runs, uint32_t n_runs, const R* ranges, uint32_t n_ranges, int run_id) {
+    auto find = [run_id](const R* table, uint32_t n) -> const R* {
+        const R* it = std::upper_bound(table, table + n, run_id,
+                                       [](int run, const R& r) { return run < r.first; });
+        if (it == table) return nullptr;
+        --it;
+        return (run_id <= it->last) ? it : nullptr;
+    };
+    if (const R* r = find(runs, n_runs)) return r;
+    return find(ranges, n_ranges);
+}
+
+} // namespace
+
+struct WCTE_Config::Json {
+    json doc;
+    WCTE_RunIndex<const json*> box_keys;      // keys with a "box" section
+    WCTE_RunIndex<const json*> quality_keys;  // keys with a dataquality.GoodRun flag
+
+    static bool readBox(const json& entry, Box& box) {
+        try {
+            const json& b = entry.at("box");
+            for (int k = 0; k < 3; ++k)
+                for (int l = 0; l < 4; ++l)
+                    box.cuts[k][l] = b.at(kSpecies[k]).at(kLimits[l]).get<double>();
+        } catch (const json::exception& e) {
+            std::cerr << "Invalid box cuts: " << e.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    static bool hasGood(const json& entry) {
+        auto dq = entry.find("dataquality");
+        return dq != entry.end() && dq->is_object() && dq->contains("GoodRun");
+    }
+
+    static bool readGood(const json& entry) {
+        auto dq = entry.find("dataquality");
+        if (dq == entry.end() || !dq->is_object()) return false;
+        auto good = dq->find("GoodRun");
+        return good != dq->end() && good->is_boolean() && good->get<bool>();
+    }
+};
+
+WCTE_Config::WCTE_Config() {}
+
+WCTE_Config::~WCTE_Config() {
+    unmap();
+}
+
+void WCTE_Config::unmap() {
+    if (map_) munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    header_ = nullptr;
+    boxes_ = nullptr;
+    quality_ = nullptr;
+}
+
+bool WCTE_Config::Load(const std::string& json_filename, const std::string& cache_file) {
+    json_.reset();
+    unmap();
+
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(json_filename, ec);
+    if (ec) {
+        std::cerr << "Error opening JSON file: " << json_filename << std::endl;
+        return false;
+    }
+    int64_t mtime = 0;
+    auto t = std::filesystem::last_write_time(json_filename, ec);
+    if (!ec) mtime = t.time_since_epoch().count();
+
+    if (!cache_file.empty() && mapCache(cache_file, mtime, size)) return true;
+
+    if (!loadJson(json_filename)) return false;
+    if (!cache_file.empty() && writeCache(cache_file, mtime, size))
+        std::cout << "Wrote config cache " << cache_file << std::endl;
+    return true;
+}
+
+bool WCTE_Config::loadJson(const std::string& json_filename) {
+    std::ifstream file(json_filename);
+    if (!file.is_open()) {
+        std::cerr << "Error opening JSON file: " << json_filename << std::endl;
+        return false;
+    }
+
+    auto parsed = std::make_unique<Json>();
+    try {
+        file >> parsed->doc;
+    } catch (const json::exception& e) {
+        std::cerr << "Cannot parse " << json_filename << ": " << e.what() << std::endl;
+        return false;
+    }
+    if (!parsed->doc.is_object()) {
+        std::cerr << json_filename << " is not a JSON object of runs" << std::endl;
+        return false;
+    }
+
+    // Keys are single runs ("1670") or run ranges ("1600-1699"); values stay in the document
+    for (auto it = parsed->doc.cbegin(); it != parsed->doc.cend(); ++it) {
+        int first, last;
+        if (!WCTE_RunIndex<const json*>::ParseRunKey(it.key(), first, last)) {
+            std::cerr << "Invalid run key '" << it.key() << "', ignored." << std::endl;
+            continue;
+        }
+        // A key only enters the index of the sections it sets, so a run key that
+        // only adjusts the box keeps the GoodRun flag of its range, and vice versa
+        const json* entry = &it.value();
+        if (Json::hasGood(*entry)) parsed->quality_keys.Insert(first, last, entry);
+        if (entry->contains("box")) parsed->box_keys.Insert(first, last, entry);
+    }
+
+    json_ = std::move(parsed);
+    return true;
+}
+
+bool WCTE_Config::mapCache(const std::string& cache_file, int64_t mtime, uint64_t size) {
+    int fd = open(cache_file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    map_ = map;
+    map_size_ = st.st_size;
+    header_ = static_cast<const Header*>(map_);
+
+    size_t n_box = (size_t)header_->n_box_runs + header_->n_box_ranges;
+    size_t n_quality = (size_t)header_->n_quality_runs + header_->n_quality_ranges;
+    bool valid = std::equal(kMagic, kMagic + 8, header_->magic) && header_->version == kVersion &&
+                 map_size_ == sizeof(Header) + n_box * sizeof(BoxRecord) + n_quality * sizeof(QualityRecord);
+    if (!valid) {
+        std::cerr << "Ignoring unreadable config cache " << cache_file << std::endl;
+        unmap();
+        return false;
+    }
+    if (header_->json_mtime != mtime || header_->json_size != size) {
+        std::cerr << "Config cache " << cache_file << " is out of date, rebuilding." << std::endl;
+        unmap();
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(map_);
+    boxes_ = reinterpret_cast<const BoxRecord*>(base + sizeof(Header));
+    quality_ = reinterpret_cast<const QualityRecord*>(base + sizeof(Header) + n_box * sizeof(BoxRecord));
+    return true;
+}
+
+bool WCTE_Config::writeCache(const std::string& cache_file, int64_t mtime, uint64_t size) const {
+    std::vector<BoxRecord> box_runs, box_ranges;
+    std::vector<QualityRecord> quality_runs, quality_ranges;
+
+    bool ok = true;
+    json_->box_keys.ForEach([&](int first, int last, const json* entry) {
+        BoxRecord r{first, last, Box()};
+        if (!Json::readBox(*entry, r.box)) {
+            ok = false;
+            return;
+        }
+        (first == last ? box_runs : box_ranges).push_back(r);
+    });
+    json_->quality_keys.ForEach([&](int first, int last, const json* entry) {
+        QualityRecord r{first, last, Json::readGood(*entry) ? 1 : 0, 0};
+        (first == last ? quality_runs : quality_ranges).push_back(r);
+    });
+    if (!ok) return false;
+
+    Header h = {};
+    std::copy(kMagic, kMagic + 8, h.magic);
+    h.version = kVersion;
+    h.json_mtime = mtime;
+    h.json_size = size;
+    h.n_box_runs = box_runs.size();
+    h.n_box_ranges = box_ranges.size();
+    h.n_quality_runs = quality_runs.size();
+    h.n_quality_ranges = quality_ranges.size();
+
+    bool written = WCTE_WriteFileAtomic(cache_file, [&](std::ostream& out) {
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(box_runs.data()), box_runs.size() * sizeof(BoxRecord));
+        out.write(reinterpret_cast<const char*>(box_ranges.data()), box_ranges.size() * sizeof(BoxRecord));
+        out.write(reinterpret_cast<const char*>(quality_runs.data()), quality_runs.size() * sizeof(QualityRecord));
+        out.write(reinterpret_cast<const char*>(quality_ranges.data()), quality_ranges.size() * sizeof(QualityRecord));
+    });
+    if (!written) std::cerr << "Cannot write config cache " << cache_file << std::endl;
+    return written;
+}
+
+bool WCTE_Config::FindBox(int run_id, Box& box) const {
+    if (map_) {
+        const BoxRecord* r = findRecord(boxes_, header_->n_box_runs,
+                                        boxes_ + header_->n_box_runs, header_->n_box_ranges, run_id);
+        if (!r) return false;
+        box = r->box;
+        return true;
+    }
+    if (!json_) return false;
+    const json* const* entry = json_->box_keys.Find(run_id);
+    return entry && Json::readBox(**entry, box);
+}
+
+bool WCTE_Config::IsGoodRun(int run_id) const {
+    if (map_) {
+        const QualityRecord* r = findRecord(quality_, header_->n_quality_runs,
+                                            quality_ + header_->n_quality_runs, header_->n_quality_ranges, run_id);
+        return r && r->good;
+    }
+    if (!json_) return false;
+    const json* const* entry = json_->quality_keys.Find(run_id);
+    return entry && Json::readGood(**entry);
+}
+
+void WCTE_Config::ForEachBox(const std::function<void(int, int, const Box&)>& f) const {
+    if (map_) {
+        size_t n = (size_t)header_->n_box_runs + header_->n_box_ranges;
+        for (size_t i = 0; i < n; ++i) f(boxes_[i].first, boxes_[i].last, boxes_[i].box);
+        return;
+    }
+    if (!json_) return;
+    json_->box_keys.ForEach([&](int first, int last, const json* entry) {
+        Box box;
+        if (Json::readBox(*entry, box)) f(first, last, box);
+    });
+}
@@ -0,0 +1,88 @@
+#ifndef WCTE_CONFIG_H
+#define WCTE_CONFIG_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Per-run settings of boxcuts.json, loaded once per job and shared by
+// WCTE_BeamMon_PID ("box" cuts) and WCTE_DataQuality ("GoodRun"). It is the
+// only reader of the file (the synthetic-data generator uses it too), so
+// there is one parser and one run-key rule.
+// Loading parses the JSON and indexes the run keys only; the values of a
+// run are read when it is asked for, so a campaign file with thousands of
+// runs costs one parse and a few lookups.
+//
+// With a cache file the resolved table is also written in a compact binary
+// layout. Later jobs memory-map it and never parse the JSON; it is rebuilt
+// when the JSON's modification time or size changes.
+class WCTE_Config {
+public:
+    // Rows {tof_min, tof_max, act_min, act_max} for electron, muon, pion
+    struct Box {
+        double cuts[3][4] = {};
+    };
+
+    WCTE_Config();
+    ~WCTE_Config();
+    WCTE_Config(const WCTE_Config&) = delete;
+    WCTE_Config& operator=(const WCTE_Config&) = delete;
+
+    // cache_file is optional; an unusable cache only costs the JSON parse
+    bool Load(const std::string& json_filename, const std::string& cache_file = "");
+
+    // Cache file next to the JSON, for tools' --config-cache option
+    static std::string DefaultCacheFile(const std::string& json_filename) { return json_filename + ".cache"; }
+
+    // Box cuts of run_id; false when no key with a "box" section covers it
+    bool FindBox(int run_id, Box& box) const;
+
+    // GoodRun flag of run_id from the keys that set dataquality.GoodRun;
+    // false (bad) when none of them covers it
+    bool IsGoodRun(int run_id) const;
+
+    // Calls f(first, last, box) for every key with a "box" section
+    void ForEachBox(const std::function<void(int, int, const Box&)>& f) const;
+
+    bool IsLoaded() const { return json_ != nullptr || map_ != nullptr; }
+    bool FromCache() const { return map_ != nullptr; }
+
+private:
+    struct Json;  // parsed document and run-key indexes
+
+    // Binary cache layout: header, box records, quality records. Each
+    // record table holds the single runs, then the ranges, sorted by first.
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        int64_t json_mtime;
+        uint64_t json_size;
+        uint32_t n_box_runs, n_box_ranges;
+        uint32_t n_quality_runs, n_quality_ranges;
+    };
+    struct BoxRecord {
+        int32_t first, last;
+        Box box;
+    };
+    struct QualityRecord {
+        int32_t first, last;
+        int32_t good, reserved;
+    };
+
+    bool loadJson(const std::string& json_filename);
+    bool mapCache(const std::string& cache_file, int64_t mtime, uint64_t size);
+    bool writeCache(const std::string& cache_file, int64_t mtime, uint64_t size) const;
+    void unmap();
+
+    std::unique_ptr<Json> json_;
+
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    const Header* header_ = nullptr;
+    const BoxRecord* boxes_ = nullptr;
+    const QualityRecord* quality_ = nullptr;
+};
+
+#endif
@@ -1,41 +1,124 @@
 #include <TFile.h>
 #include <TTree.h>
+#include <TChain.h>
 #include <TBranch.h>
 #include <TSystem.h>
 #include <TH2D.h>
+#include <TEntryList.h>
 #include <TString.h>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
 #include "WCTE_BeamMon_PID.h"
 #include "WCTE_DataQuality.h"
+#include "WCTE_EventReader.h"
+#include "WCTE_Progress.h"
+
+namespace {
+
+// Species the box PID can return; a negative code selects the same events
+// (matched on |PDG|) and only changes the output name
+bool knownPDG(int pdg) {
+    int a = std::abs(pdg);
+    return a == 11 || a == 13 || a == 211;
+}
+
+// "11", "11,13,211" or "all" -> distinct codes in the given order. Each
+// code has its own output file, so a repeated code is dropped.
+bool parsePDGList(const std::string& arg, std::vector<int>& pdgs) {
+    pdgs.clear();
+    if (arg == "all") {
+        pdgs = {11, 13, 211};
+        return true;
+    }
+    std::stringstream ss(arg);
+    std::string code;
+    while (std::getline(ss, code, ',')) {
+        int pdg = 0;
+        try {
+            size_t pos = 0;
+            pdg = std::stoi(code, &pos);
+            if (pos != code.size()) throw std::invalid_argument(code);
+        } catch (const std::exception&) {
+            std::cerr << "Invalid PDG code '" << code << "'." << std::endl;
+            return false;
+        }
+        if (!knownPDG(pdg)) {
+            std::cerr << "PDG code " << pdg << " is not a PID species (11, 13, 211)." << std::endl;
+            return false;
+        }
+        if (std::find(pdgs.begin(), pdgs.end(), pdg) == pdgs.end()) pdgs.push_back(pdg);
+    }
+    if (pdgs.empty()) {
+        std::cerr << "No PDG code given." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
 
 int main(int argc, char* argv[]) {
-    if (argc < 4) {
-        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file> <boxcuts.json> <PDG code>" << std::endl;
+    std::vector<std::string> args;
+    bool index_mode = false;
+    bool config_cache = false;
+    Long64_t max_events = -1;
+    std::string mapping_file;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--index") {
+            index_mode = true;
+        } else if (arg == "--mapping" && i + 1 < argc) {
+            mapping_file = argv[++i];
+        } else if (arg == "--config-cache") {
+            config_cache = true;
+        } else if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 3) {
+        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file|glob> [more files...] <boxcuts.json> <PDG code[,PDG...]|all> [--index] [--max-events N] [--config-cache] [--mapping <detector_mapping.txt>]" << std::endl;
+        return 1;
+    }
+    // PIDIndex has one entry per input entry so it can be a friend of the
+    // input chain; a truncated index could not be
+    if (index_mode && max_events >= 0) {
+        std::cerr << "--index covers the whole input; it cannot be combined with --max-events." << std::endl;
         return 1;
     }
 
-    std::string filename = argv[1];
-    std::string boxcutfile = argv[2];
-    int target_pdg = std::stoi(argv[3]);
+    std::vector<std::string> inputs(args.begin(), args.end() - 2);
+    std::string filename = inputs.front();
+    std::string boxcutfile = args[args.size() - 2];
 
-    TFile* infile = TFile::Open(filename.c_str());
-    if (!infile || infile->IsZombie()) {
-        std::cerr << "Error opening input ROOT file!" << std::endl;
+    // One or more PDG codes ("11", "11,13,211") or "all"; every species is
+    // skimmed in the same pass over the input
+    std::vector<int> target_pdgs;
+    if (!parsePDGList(args.back(), target_pdgs)) {
+        std::cerr << "Usage: " << argv[0] << " ... <boxcuts.json> <PDG code[,PDG...]|all>" << std::endl;
         return 1;
     }
 
-    TTree* intree = (TTree*)infile->Get("WCTEReadoutWindows");
+    TChain* intree = WCTE_EventReader::MakeChain(inputs);
     if (!intree) {
-        std::cerr << "Input tree 'WCTEReadoutWindows' not found!" << std::endl;
+        std::cerr << "Error opening input ROOT files!" << std::endl;
         return 1;
     }
 
-    // Read run_id from branch
-    int run_id = 0;
-    intree->SetBranchAddress("run_id", &run_id);
-    intree->GetEntry(0); // Read the first event to initialize run_id
+    // The skim copies every branch, so all groups stay enabled. The index
+    // only needs the beamline vectors.
+    WCTE_EventReader reader(intree, index_mode ? WCTE_EventReader::kBeamline : WCTE_EventReader::kAll);
+
+    // Read run_id from branch; PID cuts follow it per event
+    reader.GetEntry(0); // Read the first event to initialize run_id
+    int run_id = reader.run_id;
 
     std::map<int, std::string> pdg_names = {
         {11, "Electron"}, {-11, "Positron"},
@@ -44,67 +127,154 @@ int main(int argc, char* argv[]) {
     };
 
     std::cout << "Run " << run_id << " is being processed.\n";
-    std::cout << "Selected particle: PDG " << target_pdg;
-    if (pdg_names.count(target_pdg)) std::cout << " (" << pdg_names[target_pdg] << ")";
-    std::cout << "\n";
+    for (int pdg : target_pdgs) {
+        std::cout << "Selected particle: PDG " << pdg;
+        if (pdg_names.count(pdg)) std::cout << " (" << pdg_names[pdg] << ")";
+        std::cout << "\n";
+    }
 
     std::string base = gSystem->BaseName(filename.c_str());
-    std::string outname = base.substr(0, base.find(".root")) + Form("_%d.root", target_pdg);
+    base = base.substr(0, base.find(".root"));
 
-    TFile* outfile = new TFile(outname.c_str(), "RECREATE");
-    TTree* outtree = intree->CloneTree(0);
+    WCTE_BeamMon_PID pid;
+    if (!pid.LoadBoxCuts(boxcutfile, config_cache ? WCTE_Config::DefaultCacheFile(boxcutfile) : "")) return 1;
+    if (!pid.SetupChannelMap(mapping_file)) return 1;
+    pid.SetRunID(run_id);
+    if (!pid.SetPIDMethod("box")) return 1;
 
-    int pdg_value;
-    TBranch* pdg_branch = outtree->Branch("PDG", &pdg_value, "PDG/I");
+    Long64_t nentries = WCTE_Progress::Limit(reader.GetEntries(), max_events);
+    std::cout << "Total number of events: " << nentries << "\n";
+    WCTE_Progress progress("Skim", nentries);
 
-    // Add histograms
-    TH2D* h_all = new TH2D("h_all_tof_vs_act", "ACT vs TOF (All);ToF (ns);ACT3-5 QDC", 100, 10, 20, 500, 0, 20000);
-    TH2D* h_sel = new TH2D("h_sel_tof_vs_act", "ACT vs TOF (Selected);ToF (ns);ACT3-5 QDC", 100, 10, 20, 500, 0, 20000);
+    if (index_mode) {
+        // Compact skim: one PIDIndex entry per input entry (usable as a friend
+        // of the input chain) and a TEntryList per species. Nothing from the
+        // input is copied.
+        std::string outname = base + "_pidindex.root";
+        TFile* outfile = new TFile(outname.c_str(), "RECREATE");
+        outfile->cd();
 
-    // Set branches for PID
-    std::vector<float>* qdc = nullptr;
-    std::vector<int>* qdc_ids = nullptr;
-    std::vector<float>* tdc = nullptr;
-    std::vector<int>* tdc_ids = nullptr;
+        TTree* index = new TTree("PIDIndex", ("PID index of " + base).c_str());
+        int index_run, index_pdg;
+        double index_tof, index_act;
+        bool t4_hit, hole0, hole1, passes_cuts;
+        index->Branch("run_id", &index_run, "run_id/I");
+        index->Branch("PDG", &index_pdg, "PDG/I");
+        index->Branch("tof", &index_tof, "tof/D");
+        index->Branch("act", &index_act, "act/D");
+        index->Branch("t4_hit", &t4_hit, "t4_hit/O");
+        index->Branch("hole0", &hole0, "hole0/O");
+        index->Branch("hole1", &hole1, "hole1/O");
+        index->Branch("passes_cuts", &passes_cuts, "passes_cuts/O");
 
-    intree->SetBranchAddress("beamline_pmt_qdc_charges", &qdc);
-    intree->SetBranchAddress("beamline_pmt_qdc_ids", &qdc_ids);
-    intree->SetBranchAddress("beamline_pmt_tdc_times", &tdc);
-    intree->SetBranchAddress("beamline_pmt_tdc_ids", &tdc_ids);
+        std::vector<TEntryList*> lists;
+        for (int pdg : target_pdgs) {
+            TEntryList* list = new TEntryList(Form("elist_%d", pdg), Form("PDG %d", pdg));
+            lists.push_back(list);
+        }
 
-    WCTE_BeamMon_PID pid;
-    pid.LoadBoxCuts(boxcutfile);
-    pid.SetRunID(run_id);
-    pid.SetPIDMethod("box");
+        pid.WithPIDMethod([&](auto method) {
+            for (Long64_t i = 0; i < nentries; ++i) {
+                reader.GetEntry(i);
+                progress.Add();
+                pid.SetRunID(reader.run_id);
+                pid.SetBeamlineData(reader.beamline_pmt_qdc_charges, reader.beamline_pmt_qdc_ids,
+                                    reader.beamline_pmt_tdc_times, reader.beamline_pmt_tdc_ids);
 
-    Long64_t nentries = intree->GetEntries();
-    std::cout << "Total number of events: " << nentries << "\n";
-    int selected_count = 0;
-
-    for (Long64_t i = 0; i < nentries; ++i) {
-        intree->GetEntry(i);
-        pid.SetBeamlineData(qdc, qdc_ids, tdc, tdc_ids);
-
-        double tof = pid.GetTofT0T1();
-        double act = pid.GetActGroup2Sum();
-        h_all->Fill(tof, act);
-
-        int pid_code = pid.GetParticleID();
-        if (pid_code == std::abs(target_pdg)) {
-            pdg_value = pid_code;
-            outtree->Fill();
-            h_sel->Fill(tof, act);
-            selected_count++;
+                const auto& summary = pid.GetBeamlineSummary();
+                index_run = reader.run_id;
+                index_pdg = pid.GetParticleID(method);
+                index_tof = pid.GetTofT0T1();
+                index_act = pid.GetActGroup2Sum();
+                t4_hit = summary.t4_hit;
+                hole0 = summary.hole0;
+                hole1 = summary.hole1;
+                passes_cuts = summary.passes_cuts;
+                index->Fill();
+
+                if (index_pdg == 0) continue;
+                for (size_t k = 0; k < target_pdgs.size(); ++k) {
+                    if (index_pdg == std::abs(target_pdgs[k])) lists[k]->Enter(i, intree);
+                }
+            }
+        });
+
+        progress.Finish();
+
+        outfile->cd();
+        index->Write();
+        for (size_t k = 0; k < lists.size(); ++k) {
+            std::cout << "Number of selected events (PDG " << target_pdgs[k] << "): " << lists[k]->GetN() << "\n";
+            lists[k]->Write();
         }
+        outfile->Close();
+        std::cout << "PID index written to " << outname << "\n";
+        delete intree;
+        return 0;
+    }
+
+    // Histogram of all events, written to every output file
+    TH2D* h_all = new TH2D("h_all_tof_vs_act", "ACT vs TOF (All);ToF (ns);ACT3-5 QDC", 100, 10, 20, 500, 0, 20000);
+    h_all->SetDirectory(nullptr);
+
+    // One output file per species. The clones share the input branch
+    // buffers, so routing an event is a single Fill() on the matching tree.
+    struct SpeciesOutput {
+        int pdg;
+        TFile* file;
+        TTree* tree;
+        TH2D* h_sel;
+        int selected;
+    };
+    std::vector<SpeciesOutput> outputs;
+    int pdg_value;
+
+    for (int pdg : target_pdgs) {
+        std::string outname = base + Form("_%d.root", pdg);
+        TFile* outfile = new TFile(outname.c_str(), "RECREATE");
+        outfile->cd();
+        TTree* outtree = intree->CloneTree(0);
+        outtree->Branch("PDG", &pdg_value, "PDG/I");
+        TH2D* h_sel = new TH2D("h_sel_tof_vs_act", "ACT vs TOF (Selected);ToF (ns);ACT3-5 QDC", 100, 10, 20, 500, 0, 20000);
+        outputs.push_back({pdg, outfile, outtree, h_sel, 0});
     }
 
-    std::cout << "Number of selected events: " << selected_count << "\n";
+    pid.WithPIDMethod([&](auto method) {
+        for (Long64_t i = 0; i < nentries; ++i) {
+            reader.GetEntry(i);
+            progress.Add();
+            pid.SetRunID(reader.run_id);
+            pid.SetBeamlineData(reader.beamline_pmt_qdc_charges, reader.beamline_pmt_qdc_ids,
+                                reader.beamline_pmt_tdc_times, reader.beamline_pmt_tdc_ids);
+
+            double tof = pid.GetTofT0T1();
+            double act = pid.GetActGroup2Sum();
+            h_all->Fill(tof, act);
+
+            int pid_code = pid.GetParticleID(method);
+            if (pid_code == 0) continue;
 
-    outfile->cd();
-    outtree->Write();
-    h_all->Write();
-    h_sel->Write();
-    outfile->Close();
-    infile->Close();
+            for (auto& out : outputs) {
+                if (pid_code != std::abs(out.pdg)) continue;
+                pdg_value = pid_code;
+                out.tree->Fill();
+                out.h_sel->Fill(tof, act);
+                out.selected++;
+            }
+        }
+    });
+
+    progress.Finish();
+
+    for (auto& out : outputs) {
+        std::cout << "Number of selected events (PDG " << out.pdg << "): " << out.selected << "\n";
+
+        out.file->cd();
+        out.tree->Write();
+        h_all->Write();
+        out.h_sel->Write();
+        out.file->Close();
+    }
+    delete intree;
     return 0;
 }
@@ -2,6 +2,7 @@
 
 #include <TFile.h>
 #include <TTree.h>
+#include <TChain.h>
 #include <TH1D.h>
 #include <TH2D.h>
 #include <TCanvas.h>
@@ -10,181 +11,358 @@
 #include <TText.h>
 #include <TSystem.h>
 #include <TString.h>
+#include <TROOT.h>
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <set>
+#include <memory>
 #include "WCTE_BeamMon_PID.h"
+#include "WCTE_Config.h"
 #include "WCTE_DataQuality.h"
+#include "WCTE_EventReader.h"
+#include "WCTE_Output.h"
+#include "WCTE_PIDCache.h"
+#include "WCTE_PointSample.h"
+#include "WCTE_Progress.h"
+
+namespace {
+
+const char* types[] = {"Electron", "Muon", "Pion"};
+
+// One full set of PID histograms, always filled on the main thread in entry
+// order (see the --threads branch of main)
+struct PIDHistograms {
+    TH2D* all_tof_vs_act = nullptr;
+    TH1D* all_tof = nullptr;
+    TH1D* all_act = nullptr;
+    TH2D* pid_tof_vs_act[3] = {};
+    TH1D* pid_tof[3] = {};
+    TH1D* pid_act[3] = {};
+
+    // Points for the scatter overlay page, capped per category
+    WCTE_PointSample all_points;
+    WCTE_PointSample pid_points[3];
+
+    void Book(const std::string& suffix, size_t overlay_points) {
+        all_points.SetCapacity(overlay_points);
+        for (auto& p : pid_points) p.SetCapacity(overlay_points);
+
+        const char* sfx = suffix.c_str();
+        all_tof_vs_act = new TH2D(Form("h_all_tof_vs_act%s", sfx), "ACT3-5 vs TOF (All);T1-T0 (ns);ACT3-5 QDC Sum", 100, 10, 20, 500, 0, 20000);
+        all_tof = new TH1D(Form("h_all_tof%s", sfx), "TOF (All);T1-T0 (ns);Counts", 100, 10, 20);
+        all_act = new TH1D(Form("h_all_act%s", sfx), "ACT3-5 (All);ACT3-5 QDC Sum;Counts", 500, 0, 20000);
+        for (int i = 0; i < 3; ++i) {
+            pid_tof_vs_act[i] = new TH2D(Form("h_%s_tof_vs_act%s", types[i], sfx), "", 100, 10, 20, 500, 0, 20000);
+            pid_tof[i] = new TH1D(Form("h_%s_tof%s", types[i], sfx), "", 100, 10, 20);
+            pid_act[i] = new TH1D(Form("h_%s_act%s", types[i], sfx), "", 500, 0, 20000);
+        }
+    }
+};
+
+// Runs met in the event loop and the ones skipped as bad
+struct RunLog {
+    std::set<int> seen;
+    std::set<int> bad;
+};
+
+// entry keys the overlay sample, so it does not depend on the thread split
+void FillEvent(PIDHistograms& h, Long64_t entry, double tof, double act, int pid_code) {
+    if (tof < -90 || act < 0) return;
+
+    h.all_tof_vs_act->Fill(tof, act);
+    h.all_tof->Fill(tof);
+    h.all_act->Fill(act);
+
+    int p = -1;
+    if (pid_code == 11) p = 0;
+    else if (pid_code == 13) p = 1;
+    else if (pid_code == 211) p = 2;
+    if (p >= 0) { h.pid_tof_vs_act[p]->Fill(tof, act); h.pid_tof[p]->Fill(tof); h.pid_act[p]->Fill(act); }
+
+    // Only points inside the overlay frame are worth a slot
+    if (tof >= 10 && tof < 20 && act < 20000) {
+        h.all_points.Add(entry, tof, act);
+        if (p >= 0) h.pid_points[p].Add(entry, tof, act);
+    }
+}
 
-int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file> <boxcuts.json>" << std::endl;
-        return 1;
+// Instantiated once per PID method (see WCTE_BeamMon_PID::WithPIDMethod).
+// With a cache every entry is summarised, bad runs included, so the cache
+// stays valid if the data-quality flags change.
+template <class Method>
+void FillPIDHistograms(WCTE_EventReader& reader, WCTE_BeamMon_PID& pid, WCTE_DataQuality& dq,
+                       Method method, Long64_t first, Long64_t last, PIDHistograms& h, RunLog& runs,
+                       WCTE_PIDCache* cache, WCTE_Progress& progress) {
+    int current_run = -1;
+    bool good_run = false;
+
+    for (Long64_t i = first; i < last; ++i) {
+        reader.GetEntry(i);
+        progress.Add();
+
+        // Cuts and data quality follow the run_id branch, chains can span runs
+        if (reader.run_id != current_run) {
+            current_run = reader.run_id;
+            pid.SetRunID(current_run);
+            dq.SetRunID(current_run);
+            good_run = dq.IsGoodRun();
+            runs.seen.insert(current_run);
+            if (!good_run) runs.bad.insert(current_run);
+        }
+        if (!good_run && !cache) continue;
+
+        pid.SetBeamlineData(reader.beamline_pmt_qdc_charges, reader.beamline_pmt_qdc_ids,
+                            reader.beamline_pmt_tdc_times, reader.beamline_pmt_tdc_ids);
+
+        int pid_code = pid.GetParticleID(method);
+        if (cache) cache->Set(i, current_run, pid, pid_code);
+        if (!good_run) continue;
+
+        FillEvent(h, i, pid.GetTofT0T1(), pid.GetActGroup2Sum(), pid_code);
     }
+}
 
-    std::string output_pdf = "pid_selection_plots.pdf";
+// Worker part of --threads: summary and PID code of every entry in
+// [first, last) into the cache columns, bad runs included, no histograms
+template <class Method>
+void SummarisePID(WCTE_EventReader& reader, WCTE_BeamMon_PID& pid, Method method,
+                  Long64_t first, Long64_t last, WCTE_PIDCache& cache, WCTE_Progress& progress) {
+    int current_run = -1;
 
-    std::string filename = argv[1];
-    std::string boxcutfile = argv[2];
-    TFile* fileBRB = TFile::Open(filename.c_str());
-    if (!fileBRB || fileBRB->IsZombie()) {
-        std::cerr << "Error opening BRB file!" << std::endl;
-        return 1;
+    for (Long64_t i = first; i < last; ++i) {
+        reader.GetEntry(i);
+        progress.Add();
+
+        if (reader.run_id != current_run) {
+            current_run = reader.run_id;
+            pid.SetRunID(current_run);
+        }
+        pid.SetBeamlineData(reader.beamline_pmt_qdc_charges, reader.beamline_pmt_qdc_ids,
+                            reader.beamline_pmt_tdc_times, reader.beamline_pmt_tdc_ids);
+        cache.Set(i, current_run, pid, pid.GetParticleID(method));
     }
+}
 
-    TTree* tree = (TTree*)fileBRB->Get("WCTEReadoutWindows");
-    if (!tree) {
-        std::cerr << "Tree 'WCTEReadoutWindows' not found!" << std::endl;
-        return 1;
+// Same histograms from a loaded or just filled cache; no tree is read
+void FillFromCache(const WCTE_PIDCache& cache, WCTE_DataQuality& dq, PIDHistograms& h, RunLog& runs) {
+    int current_run = -1;
+    bool good_run = false;
+
+    for (size_t i = 0; i < cache.Size(); ++i) {
+        if (cache.run_id[i] != current_run) {
+            current_run = cache.run_id[i];
+            dq.SetRunID(current_run);
+            good_run = dq.IsGoodRun();
+            runs.seen.insert(current_run);
+            if (!good_run) runs.bad.insert(current_run);
+        }
+        if (!good_run) continue;
+
+        FillEvent(h, i, cache.tof[i], cache.act[i], cache.pid[i]);
     }
+}
 
+} // namespace
 
-        // Scalar branches
-    double window_time;
-    Long_t start_counter;
-    int run_id, sub_run_id, spill_counter, event_number, readout_number;
-
-    // Vector branches
-    std::vector<int>    *trigger_types = nullptr;
-    std::vector<double> *trigger_times = nullptr;
-
-    std::vector<float>  *led_gains = nullptr;
-    std::vector<float>  *led_dacsettings = nullptr;
-    std::vector<int>    *led_ids = nullptr;
-    std::vector<int>    *led_card_ids = nullptr;
-    std::vector<int>    *led_slot_numbers = nullptr;
-    std::vector<int>    *led_event_types = nullptr;
-    std::vector<int>    *led_types = nullptr;
-    std::vector<int>    *led_sequence_numbers = nullptr;
-    std::vector<int>    *led_counters = nullptr;
-
-    std::vector<int>    *hit_mpmt_card_ids = nullptr;
-    std::vector<int>    *hit_pmt_channel_ids = nullptr;
-    std::vector<int>    *hit_mpmt_slot_ids = nullptr;
-    std::vector<int>    *hit_pmt_position_ids = nullptr;
-    std::vector<float>  *hit_pmt_charges = nullptr;
-    std::vector<double> *hit_pmt_times = nullptr;
-
-    std::vector<int>    *pmt_waveform_mpmt_card_ids = nullptr;
-    std::vector<int>    *pmt_waveform_pmt_channel_ids = nullptr;
-    std::vector<int>    *pmt_waveform_mpmt_slot_ids = nullptr;
-    std::vector<int>    *pmt_waveform_pmt_position_ids = nullptr;
-    std::vector<double> *pmt_waveform_times = nullptr;
-    std::vector<std::vector<double>> *pmt_waveforms = nullptr;
-
-    // Set branch addresses
-    tree->SetBranchAddress("window_time", &window_time);
-    tree->SetBranchAddress("start_counter", &start_counter);
-    tree->SetBranchAddress("run_id", &run_id);
-    tree->SetBranchAddress("sub_run_id", &sub_run_id);
-    tree->SetBranchAddress("spill_counter", &spill_counter);
-    tree->SetBranchAddress("event_number", &event_number);
-    tree->SetBranchAddress("readout_number", &readout_number);
-
-    tree->SetBranchAddress("trigger_types", &trigger_types);
-    tree->SetBranchAddress("trigger_times", &trigger_times);
-
-    tree->SetBranchAddress("led_gains", &led_gains);
-    tree->SetBranchAddress("led_dacsettings", &led_dacsettings);
-    tree->SetBranchAddress("led_ids", &led_ids);
-    tree->SetBranchAddress("led_card_ids", &led_card_ids);
-    tree->SetBranchAddress("led_slot_numbers", &led_slot_numbers);
-    tree->SetBranchAddress("led_event_types", &led_event_types);
-    tree->SetBranchAddress("led_types", &led_types);
-    tree->SetBranchAddress("led_sequence_numbers", &led_sequence_numbers);
-    tree->SetBranchAddress("led_counters", &led_counters);
-
-    tree->SetBranchAddress("hit_mpmt_card_ids", &hit_mpmt_card_ids);
-    tree->SetBranchAddress("hit_pmt_channel_ids", &hit_pmt_channel_ids);
-    tree->SetBranchAddress("hit_mpmt_slot_ids", &hit_mpmt_slot_ids);
-    tree->SetBranchAddress("hit_pmt_position_ids", &hit_pmt_position_ids);
-    tree->SetBranchAddress("hit_pmt_charges", &hit_pmt_charges);
-    tree->SetBranchAddress("hit_pmt_times", &hit_pmt_times);
-
-    tree->SetBranchAddress("pmt_waveform_mpmt_card_ids", &pmt_waveform_mpmt_card_ids);
-    tree->SetBranchAddress("pmt_waveform_pmt_channel_ids", &pmt_waveform_pmt_channel_ids);
-    tree->SetBranchAddress("pmt_waveform_mpmt_slot_ids", &pmt_waveform_mpmt_slot_ids);
-    tree->SetBranchAddress("pmt_waveform_pmt_position_ids", &pmt_waveform_pmt_position_ids);
-    tree->SetBranchAddress("pmt_waveform_times", &pmt_waveform_times);
-    tree->SetBranchAddress("pmt_waveforms", &pmt_waveforms);
-
-    std::vector<float>* brb_qdc = nullptr;
-    std::vector<int>*   brb_qdc_ids = nullptr;
-    std::vector<float>* brb_tdc = nullptr;
-    std::vector<int>*   brb_tdc_ids = nullptr;
-
-    tree->SetBranchAddress("beamline_pmt_qdc_charges", &brb_qdc);
-    tree->SetBranchAddress("beamline_pmt_qdc_ids", &brb_qdc_ids);
-    tree->SetBranchAddress("beamline_pmt_tdc_times", &brb_tdc);
-    tree->SetBranchAddress("beamline_pmt_tdc_ids", &brb_tdc_ids);
-
-    std::string fname = gSystem->BaseName(filename.c_str());
-    size_t pos1 = fname.find("R");
-    size_t pos2 = fname.find("S");
-    run_id = 0;
-
-    if (pos1 != std::string::npos && pos2 != std::string::npos && pos2 > pos1) {
-        run_id = std::stoi(fname.substr(pos1+1, pos2-pos1-1));
-    } else {
-        std::cerr << "Cannot extract run number from filename!" << std::endl;
-        return 1;
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    int n_threads = 1;
+    Long64_t max_events = -1;
+    std::string index_file, index_pdg, cache_file, mapping_file;
+    size_t overlay_points = 50000;
+    unsigned output_mode = WCTE_Output::kPDF;
+    bool config_cache = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--config-cache") {
+            config_cache = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            n_threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else if (arg == "--index" && i + 1 < argc) {
+            index_file = argv[++i];
+        } else if (arg == "--pdg" && i + 1 < argc) {
+            index_pdg = argv[++i];
+        } else if (arg == "--pid-cache" && i + 1 < argc) {
+            cache_file = argv[++i];
+        } else if (arg == "--mapping" && i + 1 < argc) {
+            mapping_file = argv[++i];
+        } else if (arg == "--overlay-points" && i + 1 < argc) {
+            overlay_points = std::stoull(argv[++i]);
+        } else if (arg == "--output-mode" && i + 1 < argc) {
+            if (!WCTE_Output::ParseMode(argv[++i], output_mode)) return 1;
+        } else {
+            args.push_back(arg);
+        }
     }
 
-    WCTE_DataQuality dq;
-    if (!dq.LoadQualityInfo(boxcutfile)) {
-        std::cerr << "Failed to load data quality info." << std::endl;
+    if (args.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file|glob> [more files...] <boxcuts.json> [--threads N] [--max-events N] [--index <pidindex.root> --pdg <code>] [--pid-cache <file>] [--overlay-points N] [--output-mode root|json|pdf] [--config-cache] [--mapping <detector_mapping.txt>]" << std::endl;
         return 1;
     }
-    dq.SetRunID(run_id);
-    if (!dq.IsGoodRun()) {
-        std::cerr << "Run " << run_id << " is marked as BAD. Exiting." << std::endl;
+    if (!index_file.empty() && index_pdg.empty()) {
+        std::cerr << "--index needs --pdg to pick the species entry list." << std::endl;
         return 1;
     }
+    std::string index_list = "elist_" + index_pdg;
+    if (!cache_file.empty() && !index_file.empty()) {
+        std::cerr << "--pid-cache covers whole inputs and is ignored with --index." << std::endl;
+        cache_file.clear();
+    }
 
+    WCTE_Output output("pid_selection_plots", output_mode);
+    std::string output_pdf = output.GetBase() + ".pdf";
 
-    WCTE_BeamMon_PID pid;
-    if (!pid.LoadBoxCuts(boxcutfile)) {
+    std::vector<std::string> inputs(args.begin(), args.end() - 1);
+    std::string boxcutfile = args.back();
+
+    TChain* chain = WCTE_EventReader::MakeChain(inputs);
+    if (!chain) {
+        std::cerr << "Error opening BRB files!" << std::endl;
+        return 1;
+    }
+
+    // Only the beamline vectors are needed for PID; everything else stays compressed
+    WCTE_EventReader reader(chain, WCTE_EventReader::kBeamline);
+
+    // With a PID index only the entries of the chosen species are read
+    if (!index_file.empty() && !reader.SetEntryList(index_file, index_list)) return 1;
+
+    // Run IDs come from the run_id branch; cuts and quality switch per run.
+    // One configuration serves both, and the worker copies below.
+    auto config = std::make_shared<WCTE_Config>();
+    if (!config->Load(boxcutfile, config_cache ? WCTE_Config::DefaultCacheFile(boxcutfile) : "")) {
         std::cerr << "Failed to load boxcuts from file." << std::endl;
         return 1;
     }
-    pid.SetRunID(run_id);
-    pid.SetPIDMethod("box");
 
-    TH2D* h_all_tof_vs_act = new TH2D("h_all_tof_vs_act", "ACT3-5 vs TOF (All);T1-T0 (ns);ACT3-5 QDC Sum", 100, 10, 20, 500, 0, 20000);
-    TH1D* h_all_tof = new TH1D("h_all_tof", "TOF (All);T1-T0 (ns);Counts", 100, 10, 20);
-    TH1D* h_all_act = new TH1D("h_all_act", "ACT3-5 (All);ACT3-5 QDC Sum;Counts", 500, 0, 20000);
+    WCTE_DataQuality dq;
+    dq.SetConfig(config);
 
-    const char* types[] = {"Electron", "Muon", "Pion"};
-    Color_t colors[] = {kBlue, kRed, kGreen+2};
+    WCTE_BeamMon_PID pid;
+    pid.SetConfig(config);
+    if (!pid.SetupChannelMap(mapping_file)) return 1;
+    if (!pid.SetPIDMethod("box")) return 1;
 
-    TH2D* h_pid_tof_vs_act[3];
-    TH1D* h_pid_tof[3];
-    TH1D* h_pid_act[3];
+    Color_t colors[] = {kBlue, kRed, kGreen+2};
 
-    for (int i = 0; i < 3; ++i) {
-        h_pid_tof_vs_act[i] = new TH2D(Form("h_%s_tof_vs_act", types[i]), "", 100, 10, 20, 500, 0, 20000);
-        h_pid_tof[i] = new TH1D(Form("h_%s_tof", types[i]), "", 100, 10, 20);
-        h_pid_act[i] = new TH1D(Form("h_%s_act", types[i]), "", 500, 0, 20000);
+    PIDHistograms hists;
+    hists.Book("", overlay_points);
+    RunLog runs;
+
+    Long64_t nEntries = WCTE_Progress::Limit(reader.GetEntries(), max_events);
+    n_threads = (int)std::min<Long64_t>(n_threads, std::max<Long64_t>(nEntries, 1));
+
+    // A cache written for the same inputs, entry count, cuts and channel
+    // map replaces the event loop; otherwise the loop fills a new one
+    WCTE_PIDCache cache;
+    uint64_t cache_key = 0;
+    bool from_cache = false;
+    if (!cache_file.empty()) {
+        cache_key = WCTE_PIDCache::MakeKey(chain, nEntries, *config, pid.GetChannelMap());
+        from_cache = cache.Load(cache_file, cache_key);
+        if (!from_cache) cache.Resize(nEntries);
     }
+    WCTE_PIDCache* cache_out = (!cache_file.empty() && !from_cache) ? &cache : nullptr;
+
+    WCTE_Progress progress("PID", nEntries);
+    if (from_cache) {
+        std::cout << "Using PID cache " << cache_file << " (" << cache.Size() << " entries)." << std::endl;
+        FillFromCache(cache, dq, hists, runs);
+    } else if (n_threads == 1) {
+        pid.WithPIDMethod([&](auto method) {
+            FillPIDHistograms(reader, pid, dq, method, 0, nEntries, hists, runs, cache_out, progress);
+        });
+    } else {
+        // Each worker builds its own chain (trees are not thread-safe) and
+        // runs a private PID instance over a contiguous entry range, so
+        // different files are read concurrently. Workers only write their
+        // entries' summaries into the cache columns (a private cache without
+        // --pid-cache); the histograms are then filled from it here in entry
+        // order, exactly as the serial loop fills them, so the output does
+        // not depend on the number of threads.
+        ROOT::EnableThreadSafety();
+        if (!cache_out) cache.Resize(nEntries);
+
+        std::atomic<bool> failed(false);
+        std::vector<std::thread> workers;
+        for (int w = 0; w < n_threads; ++w) {
+            Long64_t first = nEntries * w / n_threads;
+            Long64_t last  = nEntries * (w + 1) / n_threads;
+            workers.emplace_back([&, first, last]() {
+                TChain* worker_chain = WCTE_EventReader::MakeChain(inputs);
+                if (!worker_chain) {
+                    failed = true;
+                    return;
+                }
+                WCTE_EventReader worker_reader(worker_chain, WCTE_EventReader::kBeamline);
+                if (!index_file.empty() && !worker_reader.SetEntryList(index_file, index_list)) {
+                    failed = true;
+                    delete worker_chain;
+                    return;
+                }
+                WCTE_BeamMon_PID worker_pid = pid;
+                worker_pid.WithPIDMethod([&](auto method) {
+                    SummarisePID(worker_reader, worker_pid, method, first, last, cache, progress);
+                });
+                delete worker_chain;
+            });
+        }
+        for (auto& th : workers) th.join();
 
-    Long64_t nEntries = std::min(tree->GetEntries(), (Long64_t)500000);
-    for (Long64_t i = 0; i < nEntries; ++i) {
-        tree->GetEntry(i);
-        pid.SetBeamlineData(brb_qdc, brb_qdc_ids, brb_tdc, brb_tdc_ids);
-
-        double tof = pid.GetTofT0T1();
-        double act = pid.GetActGroup2Sum();
+        if (failed) {
+            std::cerr << "Worker failed to open the input or index files." << std::endl;
+            return 1;
+        }
+        FillFromCache(cache, dq, hists, runs);
+    }
+    if (!from_cache) progress.Finish();
+    if (cache_out) cache.Save(cache_file, cache_key);
 
-        if (tof < -90 || act < 0) continue;
+    for (int run : runs.bad) {
+        std::cerr << "Run " << run << " is marked as BAD. Its events were skipped." << std::endl;
+    }
+    if (!runs.seen.empty() && runs.seen.size() == runs.bad.size()) {
+        std::cerr << "No good runs in the input. Exiting." << std::endl;
+        return 1;
+    }
 
-        h_all_tof_vs_act->Fill(tof, act);
-        h_all_tof->Fill(tof);
-        h_all_act->Fill(act);
+    TH2D* h_all_tof_vs_act = hists.all_tof_vs_act;
+    TH1D* h_all_tof = hists.all_tof;
+    TH1D* h_all_act = hists.all_act;
+    TH1D** h_pid_tof = hists.pid_tof;
+    TH1D** h_pid_act = hists.pid_act;
 
-        int pid_code = pid.GetParticleID();
-        if (pid_code == 11) { h_pid_tof_vs_act[0]->Fill(tof, act); h_pid_tof[0]->Fill(tof); h_pid_act[0]->Fill(act); }
-        else if (pid_code == 13) { h_pid_tof_vs_act[1]->Fill(tof, act); h_pid_tof[1]->Fill(tof); h_pid_act[1]->Fill(act); }
-        else if (pid_code == 211) { h_pid_tof_vs_act[2]->Fill(tof, act); h_pid_tof[2]->Fill(tof); h_pid_act[2]->Fill(act); }
+    output.Add(h_all_tof_vs_act);
+    output.Add(h_all_tof);
+    output.Add(h_all_act);
+    for (int i = 0; i < 3; ++i) {
+        output.Add(hists.pid_tof_vs_act[i]);
+        output.Add(h_pid_tof[i]);
+        output.Add(h_pid_act[i]);
+    }
+    double n_all = h_all_tof->GetEntries();
+    output.AddMetric("entries_read", nEntries);
+    output.AddMetric("runs", runs.seen.size());
+    output.AddMetric("bad_runs", runs.bad.size());
+    output.AddMetric("events_selected", n_all);
+    for (int i = 0; i < 3; ++i) {
+        std::string name = types[i];
+        output.AddMetric(name + "_events", h_pid_tof[i]->GetEntries());
+        output.AddMetric(name + "_fraction", n_all > 0 ? h_pid_tof[i]->GetEntries() / n_all : 0);
+        output.AddMetric(name + "_tof_mean", h_pid_tof[i]->GetMean());
+        output.AddMetric(name + "_tof_sigma", h_pid_tof[i]->GetStdDev());
+        output.AddMetric(name + "_act_mean", h_pid_act[i]->GetMean());
+    }
+    if (!output.Write()) return 1;
+    if (!output.Has(WCTE_Output::kPDF)) {
+        delete chain;
+        return 0;
     }
 
     TCanvas* c = new TCanvas("c", "PID Plots", 1200, 800);
@@ -196,7 +374,8 @@ int main(int argc, char* argv[]) {
     title->SetTextSize(0.04);
     title->Draw();
 
-    TString base_filename = gSystem->BaseName(filename.c_str());
+    TString base_filename = gSystem->BaseName(inputs.front().c_str());
+    if (inputs.size() > 1) base_filename += Form(" (+%d more)", (int)inputs.size() - 1);
     TText* fname_text = new TText(0.5, 0.4, Form("Input File: %s", base_filename.Data()));
     fname_text->SetTextAlign(22);
     fname_text->SetTextSize(0.03);
@@ -207,32 +386,10 @@ int main(int argc, char* argv[]) {
     h_all_tof_vs_act->Draw("colz");
     c->Print(output_pdf.c_str());
 
-    c->Clear();
-    TGraph* graph_all = new TGraph(h_all_tof_vs_act->GetEntries());
+    // At most --overlay-points per category, sampled during the event loop
+    TGraph* graph_all = hists.all_points.ToTGraph();
     TGraph* graph_pid[3];
-    for (int i = 0; i < 3; ++i) graph_pid[i] = new TGraph(h_pid_tof_vs_act[i]->GetEntries());
-
-    int idx_all = 0;
-    for (int ix = 1; ix <= h_all_tof_vs_act->GetNbinsX(); ++ix) {
-        for (int iy = 1; iy <= h_all_tof_vs_act->GetNbinsY(); ++iy) {
-            int entries = (int)h_all_tof_vs_act->GetBinContent(ix, iy);
-            double x = h_all_tof_vs_act->GetXaxis()->GetBinCenter(ix);
-            double y = h_all_tof_vs_act->GetYaxis()->GetBinCenter(iy);
-            for (int e = 0; e < entries; ++e) graph_all->SetPoint(idx_all++, x, y);
-        }
-    }
-
-    for (int p = 0; p < 3; ++p) {
-        int idx = 0;
-        for (int ix = 1; ix <= h_pid_tof_vs_act[p]->GetNbinsX(); ++ix) {
-            for (int iy = 1; iy <= h_pid_tof_vs_act[p]->GetNbinsY(); ++iy) {
-                int entries = (int)h_pid_tof_vs_act[p]->GetBinContent(ix, iy);
-                double x = h_pid_tof_vs_act[p]->GetXaxis()->GetBinCenter(ix);
-                double y = h_pid_tof_vs_act[p]->GetYaxis()->GetBinCenter(iy);
-                for (int e = 0; e < entries; ++e) graph_pid[p]->SetPoint(idx++, x, y);
-            }
-        }
-    }
+    for (int i = 0; i < 3; ++i) graph_pid[i] = hists.pid_points[i].ToTGraph();
 
     c->Clear();
     graph_all->SetMarkerStyle(20);
@@ -272,6 +429,6 @@ int main(int argc, char* argv[]) {
     }
 
     c->Print((output_pdf + ")").c_str());
-    fileBRB->Close();
+    delete chain;
     return 0;
 }
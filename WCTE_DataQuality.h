@@ -1,21 +1,25 @@
 #ifndef WCTE_DATAQUALITY_H
 #define WCTE_DATAQUALITY_H
 
+#include <memory>
 #include <string>
-#include <map>
+#include "WCTE_Config.h"
 
 class WCTE_DataQuality {
 public:
     WCTE_DataQuality();
 
     bool LoadQualityInfo(const std::string& json_filename);
+    // Uses a configuration already loaded for the job (e.g. shared with WCTE_BeamMon_PID)
+    void SetConfig(std::shared_ptr<const WCTE_Config> config);
     void SetRunID(int run_id);
 
     bool IsGoodRun() const;
 
 private:
     int current_run_id_;
-    std::map<int, bool> run_quality_; // Run ID -> GoodRun flag
+    bool current_good_ = false;            // Resolved in SetRunID()
+    std::shared_ptr<const WCTE_Config> config_;  // Run ID / range -> GoodRun flag
 };
 
 #endif
@@ -0,0 +1,161 @@
+#include "WCTE_EventMatch.h"
+#include "WCTE_Log.h"
+#include <TString.h>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+WCTE_LogReason dropKeyUnreadable("EventMatch: key not evaluable");
+WCTE_LogReason dropKeyRepeated("EventMatch: repeated key in index");
+
+uint64_t mix(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+WCTE_EventMatch::~WCTE_EventMatch() {
+    clear(index_key_);
+    clear(probe_key_);
+}
+
+void WCTE_EventMatch::clear(KeyFormula& key) {
+    for (TTreeFormula* f : key.terms) delete f;
+    key.terms.clear();
+    key.tree = nullptr;
+    key.tree_number = -1;
+}
+
+// Splits on ':' but not on the '::' of names such as TMath::Nint
+std::vector<std::string> WCTE_EventMatch::split(const std::string& keys) {
+    std::vector<std::string> out;
+    std::string expr;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == ':' && i + 1 < keys.size() && keys[i + 1] == ':') {
+            expr += "::";
+            ++i;
+        } else if (keys[i] == ':') {
+            if (!expr.empty()) out.push_back(expr);
+            expr.clear();
+        } else {
+            expr += keys[i];
+        }
+    }
+    if (!expr.empty()) out.push_back(expr);
+    return out;
+}
+
+bool WCTE_EventMatch::parse(TTree* tree, const std::string& keys, KeyFormula& key) {
+    clear(key);
+    if (!tree) return false;
+    key.tree = tree;
+
+    for (const std::string& expr : split(keys)) {
+        TTreeFormula* f = new TTreeFormula(Form("key%zu", key.terms.size()), expr.c_str(), tree);
+        if (f->GetNdim() == 0) {
+            std::cerr << "Cannot evaluate key '" << expr << "' on tree " << tree->GetName() << std::endl;
+            delete f;
+            clear(key);
+            return false;
+        }
+        key.terms.push_back(f);
+    }
+    if (key.terms.empty()) {
+        std::cerr << "Empty match key for tree " << tree->GetName() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool WCTE_EventMatch::eval(KeyFormula& key, Long64_t entry, std::vector<int64_t>& values) {
+    if (key.tree->LoadTree(entry) < 0) return false;
+    // A TChain moves to a new file: the formulas must re-bind their leaves
+    if (key.tree->GetTreeNumber() != key.tree_number) {
+        key.tree_number = key.tree->GetTreeNumber();
+        for (TTreeFormula* f : key.terms) f->UpdateFormulaLeaves();
+    }
+
+    values.clear();
+    for (TTreeFormula* f : key.terms) {
+        if (f->GetNdata() < 1) return false;
+        double v = f->EvalInstance(0);
+        if (!std::isfinite(v)) return false;
+        values.push_back(std::llround(v));
+    }
+    return true;
+}
+
+uint64_t WCTE_EventMatch::hash(const std::vector<int64_t>& values) {
+    uint64_t h = values.size();
+    for (int64_t v : values) h = mix(h ^ (uint64_t)v);
+    return h;
+}
+
+bool WCTE_EventMatch::Build(TTree* tree, const std::string& keys, Long64_t n_entries) {
+    if (!parse(tree, keys, index_key_)) return false;
+    if (n_entries < 0 || n_entries > tree->GetEntries()) n_entries = tree->GetEntries();
+
+    // Power of two, at least twice the entries: short linear probes
+    size_t capacity = 16;
+    while (capacity < 2 * (size_t)n_entries) capacity <<= 1;
+    slots_.assign(capacity, Slot{0, -1});
+    size_ = 0;
+    duplicates_ = 0;
+
+    const size_t mask = capacity - 1;
+    for (Long64_t i = 0; i < n_entries; ++i) {
+        if (!eval(index_key_, i, values_)) {
+            WCTE_LOG_EXAMPLE(dropKeyUnreadable, tree->GetName() << " entry " << i);
+            continue;
+        }
+        uint64_t h = hash(values_);
+        size_t pos = h & mask;
+        bool repeated = false;
+        while (slots_[pos].entry >= 0) {
+            if (slots_[pos].hash == h && eval(index_key_, slots_[pos].entry, check_) && check_ == values_) {
+                repeated = true;
+                break;
+            }
+            pos = (pos + 1) & mask;
+        }
+        if (repeated) {
+            ++duplicates_;
+            WCTE_LOG_EXAMPLE(dropKeyRepeated, tree->GetName() << " entry " << i << " repeats entry " << slots_[pos].entry);
+            continue;
+        }
+        slots_[pos] = Slot{h, i};
+        ++size_;
+    }
+    return true;
+}
+
+bool WCTE_EventMatch::SetProbe(TTree* tree, const std::string& keys) {
+    if (!parse(tree, keys, probe_key_)) return false;
+    if (probe_key_.terms.size() != index_key_.terms.size()) {
+        std::cerr << "Match keys differ in length: " << index_key_.terms.size()
+                  << " vs " << probe_key_.terms.size() << " expressions" << std::endl;
+        clear(probe_key_);
+        return false;
+    }
+    return true;
+}
+
+Long64_t WCTE_EventMatch::Find(Long64_t probe_entry) {
+    if (slots_.empty() || probe_key_.terms.empty()) return -1;
+    if (!eval(probe_key_, probe_entry, values_)) {
+        WCTE_LOG_EXAMPLE(dropKeyUnreadable, probe_key_.tree->GetName() << " entry " << probe_entry);
+        return -1;
+    }
+
+    uint64_t h = hash(values_);
+    const size_t mask = slots_.size() - 1;
+    for (size_t pos = h & mask; slots_[pos].entry >= 0; pos = (pos + 1) & mask) {
+        if (slots_[pos].hash != h) continue;
+        if (eval(index_key_, slots_[pos].entry, check_) && check_ == values_) return slots_[pos].entry;
+    }
+    return -1;
+}
@@ -0,0 +1,68 @@
+#ifndef WCTE_EVENTMATCH_H
+#define WCTE_EVENTMATCH_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <TTree.h>
+#include <TTreeFormula.h>
+
+// Event-by-event join of two trees (BRB WCTEReadoutWindows and VME
+// beam_monitor_calib) on a shared key. A key is a colon-separated list of
+// TTreeFormula expressions evaluated per entry and rounded to integers, e.g.
+// "spill_counter:event_number", or a bucketed timestamp such as
+// "spill_counter:TMath::Nint(window_time/1000)".
+//
+// Build() reads only the key branches of the indexed tree, once, into an
+// open-addressing hash table of 16-byte (key hash, entry) slots kept at most
+// half full; no event data is held. Find() then reads the probe key, looks
+// it up and re-reads the key of the hit to rule out hash collisions, so a
+// full run is joined in O(N).
+class WCTE_EventMatch {
+public:
+    static constexpr const char* kDefaultKeys = "spill_counter:event_number";
+
+    WCTE_EventMatch() = default;
+    WCTE_EventMatch(const WCTE_EventMatch&) = delete;
+    WCTE_EventMatch& operator=(const WCTE_EventMatch&) = delete;
+    ~WCTE_EventMatch();
+
+    // Indexes entries [0, n_entries) of tree (all of them if n_entries < 0).
+    // The first entry wins when a key repeats; repeats are counted.
+    bool Build(TTree* tree, const std::string& keys, Long64_t n_entries = -1);
+
+    // Key expressions for the other tree; same number of expressions as Build()
+    bool SetProbe(TTree* tree, const std::string& keys);
+
+    // Entry of the indexed tree with the key of probe entry, or -1
+    Long64_t Find(Long64_t probe_entry);
+
+    size_t Size() const { return size_; }
+    Long64_t GetDuplicates() const { return duplicates_; }
+
+private:
+    struct KeyFormula {
+        TTree* tree = nullptr;
+        std::vector<TTreeFormula*> terms;
+        int tree_number = -1;
+    };
+
+    struct Slot {
+        uint64_t hash;
+        Long64_t entry;  // -1 for an empty slot
+    };
+
+    static std::vector<std::string> split(const std::string& keys);
+    static bool parse(TTree* tree, const std::string& keys, KeyFormula& key);
+    static bool eval(KeyFormula& key, Long64_t entry, std::vector<int64_t>& values);
+    static uint64_t hash(const std::vector<int64_t>& values);
+    static void clear(KeyFormula& key);
+
+    KeyFormula index_key_, probe_key_;
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+    Long64_t duplicates_ = 0;
+    std::vector<int64_t> values_, check_;
+};
+
+#endif
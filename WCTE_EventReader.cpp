@@ -0,0 +1,134 @@
+#include "WCTE_EventReader.h"
+#include <TFile.h>
+#include <iostream>
+#include <memory>
+
+WCTE_EventReader::WCTE_EventReader(TTree* tree, unsigned groups)
+    : tree_(tree), groups_(groups | kHeader) {
+    if (!tree_) return;
+
+    // Start from nothing and switch on only what was asked for
+    tree_->SetBranchStatus("*", 0);
+
+    attach("window_time", &window_time);
+    attach("start_counter", &start_counter);
+    attach("run_id", &run_id);
+    attach("sub_run_id", &sub_run_id);
+    attach("spill_counter", &spill_counter);
+    attach("event_number", &event_number);
+    attach("readout_number", &readout_number);
+
+    if (Has(kTrigger)) {
+        attach("trigger_types", &trigger_types);
+        attach("trigger_times", &trigger_times);
+    }
+
+    if (Has(kLED)) {
+        attach("led_gains", &led_gains);
+        attach("led_dacsettings", &led_dacsettings);
+        attach("led_ids", &led_ids);
+        attach("led_card_ids", &led_card_ids);
+        attach("led_slot_numbers", &led_slot_numbers);
+        attach("led_event_types", &led_event_types);
+        attach("led_types", &led_types);
+        attach("led_sequence_numbers", &led_sequence_numbers);
+        attach("led_counters", &led_counters);
+    }
+
+    if (Has(kHitPMT)) {
+        attach("hit_mpmt_card_ids", &hit_mpmt_card_ids);
+        attach("hit_pmt_channel_ids", &hit_pmt_channel_ids);
+        attach("hit_mpmt_slot_ids", &hit_mpmt_slot_ids);
+        attach("hit_pmt_position_ids", &hit_pmt_position_ids);
+        attach("hit_pmt_charges", &hit_pmt_charges);
+        attach("hit_pmt_times", &hit_pmt_times);
+    }
+
+    if (Has(kWaveform)) {
+        attach("pmt_waveform_mpmt_card_ids", &pmt_waveform_mpmt_card_ids);
+        attach("pmt_waveform_pmt_channel_ids", &pmt_waveform_pmt_channel_ids);
+        attach("pmt_waveform_mpmt_slot_ids", &pmt_waveform_mpmt_slot_ids);
+        attach("pmt_waveform_pmt_position_ids", &pmt_waveform_pmt_position_ids);
+        attach("pmt_waveform_times", &pmt_waveform_times);
+        attach("pmt_waveforms", &pmt_waveforms);
+    }
+
+    if (Has(kBeamline)) {
+        attach("beamline_pmt_qdc_charges", &beamline_pmt_qdc_charges);
+        attach("beamline_pmt_qdc_ids", &beamline_pmt_qdc_ids);
+        attach("beamline_pmt_tdc_times", &beamline_pmt_tdc_times);
+        attach("beamline_pmt_tdc_ids", &beamline_pmt_tdc_ids);
+    }
+}
+
+template <typename T>
+void WCTE_EventReader::attach(const char* name, T* address) {
+    if (!tree_->GetBranch(name)) {
+        std::cerr << "Warning: branch '" << name << "' not found in tree." << std::endl;
+        return;
+    }
+    tree_->SetBranchStatus(name, 1);
+    tree_->SetBranchAddress(name, address);
+}
+
+TChain* WCTE_EventReader::MakeChain(const std::vector<std::string>& inputs) {
+    TChain* chain = new TChain("WCTEReadoutWindows");
+    int n_files = 0;
+    for (const auto& input : inputs) {
+        int added = chain->Add(input.c_str());
+        if (added == 0) std::cerr << "Warning: no files matched '" << input << "'." << std::endl;
+        n_files += added;
+    }
+    if (n_files == 0) {
+        delete chain;
+        return nullptr;
+    }
+    return chain;
+}
+
+bool WCTE_EventReader::SetEntryList(const std::string& index_file, const std::string& list_name) {
+    if (!tree_) return false;
+
+    std::unique_ptr<TFile> file(TFile::Open(index_file.c_str()));
+    if (!file || file->IsZombie()) {
+        std::cerr << "Cannot open PID index file " << index_file << std::endl;
+        return false;
+    }
+    TEntryList* list = file->Get<TEntryList>(list_name.c_str());
+    if (!list) {
+        std::cerr << "No entry list '" << list_name << "' in " << index_file << std::endl;
+        return false;
+    }
+
+    // Keep the list after the file is closed; it lives as long as the job
+    list->SetDirectory(nullptr);
+    file->Close();
+
+    // Sub-lists are matched to the chain by tree and file name, so the
+    // inputs must be the files the index was made from
+    tree_->SetEntryList(list);
+    entry_list_ = list;
+    return true;
+}
+
+Long64_t WCTE_EventReader::GetEntries() const {
+    if (!tree_) return 0;
+    return entry_list_ ? entry_list_->GetN() : tree_->GetEntries();
+}
+
+int WCTE_EventReader::GetEntry(Long64_t entry) {
+    if (!tree_) return 0;
+    if (entry_list_) entry = tree_->GetEntryNumber(entry);
+    return GetTreeEntry(entry);
+}
+
+int WCTE_EventReader::GetTreeEntry(Long64_t tree_entry) {
+    if (!tree_ || tree_entry < 0) return 0;
+
+    int bytes = tree_->GetEntry(tree_entry);
+    if (Has(kHitPMT)) {
+        if (hit_mpmt_card_ids) hit_index.Build(*hit_mpmt_card_ids);
+        else hit_index.Clear();
+    }
+    return bytes;
+}
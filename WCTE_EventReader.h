@@ -0,0 +1,102 @@
+#ifndef WCTE_EVENTREADER_H
+#define WCTE_EVENTREADER_H
+
+#include <vector>
+#include <string>
+#include <TTree.h>
+#include <TChain.h>
+#include <TEntryList.h>
+#include "WCTE_HitIndex.h"
+
+// Shared reader for the WCTEReadoutWindows tree.
+// Tools declare the branch groups they need; every other branch is disabled
+// with SetBranchStatus so GetEntry() never decompresses it.
+class WCTE_EventReader {
+public:
+    enum BranchGroup : unsigned {
+        kHeader   = 1u << 0,  // run/spill/event scalars, always enabled
+        kBeamline = 1u << 1,  // beamline_pmt_qdc_* / beamline_pmt_tdc_*
+        kHitPMT   = 1u << 2,  // hit_mpmt_* / hit_pmt_*
+        kWaveform = 1u << 3,  // pmt_waveform_* / pmt_waveforms
+        kLED      = 1u << 4,  // led_*
+        kTrigger  = 1u << 5,  // trigger_types / trigger_times
+        kAll      = kHeader | kBeamline | kHitPMT | kWaveform | kLED | kTrigger
+    };
+
+    WCTE_EventReader(TTree* tree, unsigned groups);
+
+    // Chain of WCTEReadoutWindows trees over files or globs
+    // (e.g. "data/WCTE_offline_R1670S*.root"). Returns nullptr if no file matched.
+    static TChain* MakeChain(const std::vector<std::string>& inputs);
+
+    TTree* GetTree() const { return tree_; }
+    unsigned GetGroups() const { return groups_; }
+    bool Has(BranchGroup group) const { return (groups_ & group) != 0; }
+
+    // Restrict reading to a TEntryList stored in a PID index file written by
+    // WCTE_CreatePIDFilteredSample --index (e.g. "elist_211"). GetEntries()
+    // and GetEntry(i) then run over the selected entries only.
+    bool SetEntryList(const std::string& index_file, const std::string& list_name);
+
+    Long64_t GetEntries() const;
+    int GetEntry(Long64_t entry);
+
+    // Reads entry tree_entry of the tree itself, ignoring any entry list
+    // (e.g. to calibrate on the unfiltered input of an indexed job)
+    int GetTreeEntry(Long64_t tree_entry);
+
+    // Header scalars
+    double window_time = 0;
+    Long_t start_counter = 0;
+    int run_id = 0, sub_run_id = 0, spill_counter = 0, event_number = 0, readout_number = 0;
+
+    // Trigger
+    std::vector<int>    *trigger_types = nullptr;
+    std::vector<double> *trigger_times = nullptr;
+
+    // LED
+    std::vector<float>  *led_gains = nullptr;
+    std::vector<float>  *led_dacsettings = nullptr;
+    std::vector<int>    *led_ids = nullptr;
+    std::vector<int>    *led_card_ids = nullptr;
+    std::vector<int>    *led_slot_numbers = nullptr;
+    std::vector<int>    *led_event_types = nullptr;
+    std::vector<int>    *led_types = nullptr;
+    std::vector<int>    *led_sequence_numbers = nullptr;
+    std::vector<int>    *led_counters = nullptr;
+
+    // Hit PMT
+    std::vector<int>    *hit_mpmt_card_ids = nullptr;
+    std::vector<int>    *hit_pmt_channel_ids = nullptr;
+    std::vector<int>    *hit_mpmt_slot_ids = nullptr;
+    std::vector<int>    *hit_pmt_position_ids = nullptr;
+    std::vector<float>  *hit_pmt_charges = nullptr;
+    std::vector<double> *hit_pmt_times = nullptr;
+
+    // Hit PMT positions by card, rebuilt by GetEntry() when kHitPMT is read
+    WCTE_HitIndex hit_index;
+
+    // Waveforms
+    std::vector<int>    *pmt_waveform_mpmt_card_ids = nullptr;
+    std::vector<int>    *pmt_waveform_pmt_channel_ids = nullptr;
+    std::vector<int>    *pmt_waveform_mpmt_slot_ids = nullptr;
+    std::vector<int>    *pmt_waveform_pmt_position_ids = nullptr;
+    std::vector<double> *pmt_waveform_times = nullptr;
+    std::vector<std::vector<double>> *pmt_waveforms = nullptr;
+
+    // Beamline
+    std::vector<float>  *beamline_pmt_qdc_charges = nullptr;
+    std::vector<int>    *beamline_pmt_qdc_ids = nullptr;
+    std::vector<float>  *beamline_pmt_tdc_times = nullptr;
+    std::vector<int>    *beamline_pmt_tdc_ids = nullptr;
+
+private:
+    template <typename T>
+    void attach(const char* name, T* address);
+
+    TTree* tree_ = nullptr;
+    TEntryList* entry_list_ = nullptr;
+    unsigned groups_ = 0;
+};
+
+#endif
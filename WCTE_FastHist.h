@@ -0,0 +1,120 @@
+#ifndef WCTE_FASTHIST_H
+#define WCTE_FASTHIST_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <TH1D.h>
+#include <TH2D.h>
+
+// Fill-only histograms for event loops: uniform binning, integer counts in
+// one contiguous array, no per-fill statistics. Bin numbering follows TH1
+// (0 underflow, 1..nbins, nbins + 1 overflow; NaN goes to the overflow), so
+// ToTH1D()/ToTH2D() at output time give the bin contents TH1::Fill would
+// have; mean and RMS are then computed from the bin centres.
+// Instances share nothing; give each thread its own and Add() them at the end.
+
+struct FastAxis {
+    int nbins;
+    double xmin, xmax;
+
+    constexpr FastAxis(int n, double lo, double hi) : nbins(n), xmin(lo), xmax(hi) {}
+
+    // Same arithmetic as TAxis::FindFixBin
+    constexpr int FindBin(double x) const {
+        if (x < xmin) return 0;
+        if (!(x < xmax)) return nbins + 1;
+        return 1 + int(nbins * (x - xmin) / (xmax - xmin));
+    }
+
+    constexpr bool operator==(const FastAxis& o) const {
+        return nbins == o.nbins && xmin == o.xmin && xmax == o.xmax;
+    }
+};
+
+class FastHist1D {
+public:
+    FastHist1D(int nbins, double xmin, double xmax) : x_(nbins, xmin, xmax), counts_(nbins + 2, 0) {}
+    explicit FastHist1D(const FastAxis& x) : x_(x), counts_(x.nbins + 2, 0) {}
+
+    void Fill(double x) { ++counts_[x_.FindBin(x)]; }
+
+    // Adds the counts of a histogram with the same binning
+    bool Add(const FastHist1D& other) {
+        if (!(x_ == other.x_)) return false;
+        for (size_t b = 0; b < counts_.size(); ++b) counts_[b] += other.counts_[b];
+        return true;
+    }
+
+    void Reset() { std::fill(counts_.begin(), counts_.end(), 0); }
+
+    const FastAxis& GetAxis() const { return x_; }
+    uint64_t GetBinContent(int bin) const { return counts_[bin]; }
+    uint64_t GetEntries() const {
+        uint64_t n = 0;
+        for (uint64_t c : counts_) n += c;
+        return n;
+    }
+
+    // New TH1D (owned by the caller) with these counts
+    TH1D* ToTH1D(const char* name, const char* title) const {
+        TH1D* h = new TH1D(name, title, x_.nbins, x_.xmin, x_.xmax);
+        for (int b = 0; b <= x_.nbins + 1; ++b) {
+            if (counts_[b]) h->SetBinContent(b, (double)counts_[b]);
+        }
+        h->ResetStats();
+        h->SetEntries((double)GetEntries());
+        return h;
+    }
+
+private:
+    FastAxis x_;
+    std::vector<uint64_t> counts_;
+};
+
+class FastHist2D {
+public:
+    FastHist2D(int nx, double xmin, double xmax, int ny, double ymin, double ymax)
+        : x_(nx, xmin, xmax), y_(ny, ymin, ymax), counts_((size_t)(nx + 2) * (ny + 2), 0) {}
+
+    // Global bin as TH1::GetBin(bx, by)
+    void Fill(double x, double y) {
+        ++counts_[x_.FindBin(x) + (size_t)(x_.nbins + 2) * y_.FindBin(y)];
+    }
+
+    bool Add(const FastHist2D& other) {
+        if (!(x_ == other.x_) || !(y_ == other.y_)) return false;
+        for (size_t b = 0; b < counts_.size(); ++b) counts_[b] += other.counts_[b];
+        return true;
+    }
+
+    void Reset() { std::fill(counts_.begin(), counts_.end(), 0); }
+
+    const FastAxis& GetXaxis() const { return x_; }
+    const FastAxis& GetYaxis() const { return y_; }
+    uint64_t GetBinContent(int bx, int by) const { return counts_[bx + (size_t)(x_.nbins + 2) * by]; }
+    uint64_t GetEntries() const {
+        uint64_t n = 0;
+        for (uint64_t c : counts_) n += c;
+        return n;
+    }
+
+    TH2D* ToTH2D(const char* name, const char* title) const {
+        TH2D* h = new TH2D(name, title, x_.nbins, x_.xmin, x_.xmax, y_.nbins, y_.xmin, y_.xmax);
+        for (int by = 0; by <= y_.nbins + 1; ++by) {
+            for (int bx = 0; bx <= x_.nbins + 1; ++bx) {
+                uint64_t c = GetBinContent(bx, by);
+                if (c) h->SetBinContent(bx, by, (double)c);
+            }
+        }
+        h->ResetStats();
+        h->SetEntries((double)GetEntries());
+        return h;
+    }
+
+private:
+    FastAxis x_, y_;
+    std::vector<uint64_t> counts_;
+};
+
+#endif
@@ -0,0 +1,327 @@
+// WCTE_GenerateSyntheticData.cpp
+//
+// Writes a synthetic WCTEReadoutWindows tree with the branch layout of the
+// BRB offline files, for load testing the tools without real data.
+// Beamline TOF / ACT3-5 values are drawn inside the boxcuts.json boxes of
+// the chosen run, so the PID tools classify the events as generated.
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TRandom3.h>
+#include <TString.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cmath>
+#include "WCTE_Config.h"
+#include "WCTE_Progress.h"
+
+namespace {
+
+// Beamline PMT on the hit PMT cards (card, channel -> beamline index)
+struct BeamlineHitChannel {
+    int card, channel, index;
+};
+
+// Format: detector_name,card,channel,beamline_index (one header line)
+std::vector<BeamlineHitChannel> loadBeamlineHitChannels(const std::string& filename) {
+    std::vector<BeamlineHitChannel> channels;
+    std::ifstream file(filename);
+    if (!file.is_open()) return channels;
+
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string name;
+        int card, channel, index;
+        char comma;
+        std::getline(iss, name, ',');
+        if (!(iss >> card >> comma >> channel >> comma >> index)) continue;
+        if (index >= 0 && index < 64 && name != "NC") channels.push_back({card, channel, index});
+    }
+    return channels;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string output, boxcutfile = "boxcuts.json", mappingfile = "detector_mapping.txt";
+    Long64_t n_events = 100000;
+    int run_id = 1670;
+    int n_cards = 106;
+    double hits_per_card = 2.0;
+    double fractions[4] = {0.3, 0.2, 0.4, 0.1};  // e, mu, pi, outside every box
+    bool waveforms = false;
+    unsigned seed = 4357;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--events" && i + 1 < argc) {
+            n_events = std::stoll(argv[++i]);
+        } else if (arg == "--run" && i + 1 < argc) {
+            run_id = std::stoi(argv[++i]);
+        } else if (arg == "--boxcuts" && i + 1 < argc) {
+            boxcutfile = argv[++i];
+        } else if (arg == "--mapping" && i + 1 < argc) {
+            mappingfile = argv[++i];
+        } else if (arg == "--cards" && i + 1 < argc) {
+            n_cards = std::stoi(argv[++i]);
+        } else if (arg == "--hits-per-card" && i + 1 < argc) {
+            hits_per_card = std::stod(argv[++i]);
+        } else if (arg == "--fractions" && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            std::string f;
+            for (int k = 0; k < 4 && std::getline(ss, f, ','); ++k) fractions[k] = std::stod(f);
+        } else if (arg == "--waveforms") {
+            waveforms = true;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoul(argv[++i]);
+        } else if (output.empty() && arg[0] != '-') {
+            output = arg;
+        } else {
+            output.clear();
+            break;
+        }
+    }
+
+    if (output.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <output.root> [--events N] [--run R] [--boxcuts boxcuts.json]"
+                  << " [--mapping detector_mapping.txt] [--cards C] [--hits-per-card H]"
+                  << " [--fractions e,mu,pi,other] [--waveforms] [--seed S]" << std::endl;
+        return 1;
+    }
+
+    // Rows of box.cuts: electron, muon, pion
+    WCTE_Config config;
+    WCTE_Config::Box box;
+    if (!config.Load(boxcutfile)) return 1;
+    if (!config.FindBox(run_id, box)) {
+        std::cerr << "No valid box cuts for run " << run_id << " in " << boxcutfile << std::endl;
+        return 1;
+    }
+
+    std::vector<BeamlineHitChannel> beamline_hits = loadBeamlineHitChannels(mappingfile);
+    if (beamline_hits.empty()) {
+        std::cerr << "No mapping from " << mappingfile << ", beamline PMTs get only the card 131 T0 hits." << std::endl;
+        for (int k = 0; k < 4; ++k) beamline_hits.push_back({131, 12 + k, k});
+    }
+
+    double fraction_sum = fractions[0] + fractions[1] + fractions[2] + fractions[3];
+    if (fraction_sum <= 0) {
+        std::cerr << "Species fractions must add up to more than zero." << std::endl;
+        return 1;
+    }
+
+    TFile* outfile = new TFile(output.c_str(), "RECREATE");
+    if (!outfile || outfile->IsZombie()) {
+        std::cerr << "Error creating " << output << std::endl;
+        return 1;
+    }
+    TTree* tree = new TTree("WCTEReadoutWindows", "Synthetic WCTE readout windows");
+
+    // Header
+    double window_time = 0;
+    Long_t start_counter = 0;
+    int run = run_id, sub_run_id = 0, spill_counter = 0, event_number = 0, readout_number = 0;
+    tree->Branch("window_time", &window_time);
+    tree->Branch("start_counter", &start_counter);
+    tree->Branch("run_id", &run);
+    tree->Branch("sub_run_id", &sub_run_id);
+    tree->Branch("spill_counter", &spill_counter);
+    tree->Branch("event_number", &event_number);
+    tree->Branch("readout_number", &readout_number);
+
+    // Trigger and LED (LED windows are not generated, the vectors stay empty)
+    std::vector<int> trigger_types;
+    std::vector<double> trigger_times;
+    std::vector<float> led_gains, led_dacsettings;
+    std::vector<int> led_ids, led_card_ids, led_slot_numbers, led_event_types, led_types,
+                     led_sequence_numbers, led_counters;
+    tree->Branch("trigger_types", &trigger_types);
+    tree->Branch("trigger_times", &trigger_times);
+    tree->Branch("led_gains", &led_gains);
+    tree->Branch("led_dacsettings", &led_dacsettings);
+    tree->Branch("led_ids", &led_ids);
+    tree->Branch("led_card_ids", &led_card_ids);
+    tree->Branch("led_slot_numbers", &led_slot_numbers);
+    tree->Branch("led_event_types", &led_event_types);
+    tree->Branch("led_types", &led_types);
+    tree->Branch("led_sequence_numbers", &led_sequence_numbers);
+    tree->Branch("led_counters", &led_counters);
+
+    // Hit PMT
+    std::vector<int> hit_mpmt_card_ids, hit_pmt_channel_ids, hit_mpmt_slot_ids, hit_pmt_position_ids;
+    std::vector<float> hit_pmt_charges;
+    std::vector<double> hit_pmt_times;
+    tree->Branch("hit_mpmt_card_ids", &hit_mpmt_card_ids);
+    tree->Branch("hit_pmt_channel_ids", &hit_pmt_channel_ids);
+    tree->Branch("hit_mpmt_slot_ids", &hit_mpmt_slot_ids);
+    tree->Branch("hit_pmt_position_ids", &hit_pmt_position_ids);
+    tree->Branch("hit_pmt_charges", &hit_pmt_charges);
+    tree->Branch("hit_pmt_times", &hit_pmt_times);
+
+    // Waveforms
+    std::vector<int> wf_card_ids, wf_channel_ids, wf_slot_ids, wf_position_ids;
+    std::vector<double> wf_times;
+    std::vector<std::vector<double>> wf_samples;
+    tree->Branch("pmt_waveform_mpmt_card_ids", &wf_card_ids);
+    tree->Branch("pmt_waveform_pmt_channel_ids", &wf_channel_ids);
+    tree->Branch("pmt_waveform_mpmt_slot_ids", &wf_slot_ids);
+    tree->Branch("pmt_waveform_pmt_position_ids", &wf_position_ids);
+    tree->Branch("pmt_waveform_times", &wf_times);
+    tree->Branch("pmt_waveforms", &wf_samples);
+
+    // Beamline
+    std::vector<float> qdc_charges, tdc_times;
+    std::vector<int> qdc_ids, tdc_ids;
+    tree->Branch("beamline_pmt_qdc_charges", &qdc_charges);
+    tree->Branch("beamline_pmt_qdc_ids", &qdc_ids);
+    tree->Branch("beamline_pmt_tdc_times", &tdc_times);
+    tree->Branch("beamline_pmt_tdc_ids", &tdc_ids);
+
+    TRandom3 rng(seed);
+    const int kWaveformSamples = 32;
+    const double t0_hit_offset[4] = {2198.0, 2199.5, 2200.5, 2202.0};  // card 131 ch 12-15
+    long generated[4] = {0, 0, 0, 0};
+
+    WCTE_Progress progress("Generate", n_events);
+    for (Long64_t i = 0; i < n_events; ++i) {
+        event_number = readout_number = (int)i;
+        if (i > 0 && i % 10000 == 0) ++spill_counter;
+        window_time = i * 1.6e4 + rng.Uniform(0, 100);
+        start_counter = (Long_t)(window_time / 8);
+
+        trigger_types.assign(1, 0);
+        trigger_times.assign(1, window_time);
+
+        // Species and its beamline TOF / ACT3-5 sum
+        double r = rng.Uniform(0, fraction_sum);
+        int species = 3;
+        for (int k = 0; k < 3; ++k) {
+            if (r < fractions[k]) { species = k; break; }
+            r -= fractions[k];
+        }
+        ++generated[species];
+
+        double tof, act;
+        if (species < 3) {
+            const double* b = box.cuts[species];  // tof_min, tof_max, act_min, act_max
+            tof = rng.Uniform(b[0], b[1]);
+            act = rng.Uniform(b[2], b[3]);
+        } else {
+            tof = rng.Uniform(10, 12);  // below every box
+            act = rng.Uniform(0, 20000);
+        }
+
+        // Beamline QDC: every channel read out; T4 above 300 and hole
+        // counters quiet for most windows; ACT3-5 share the sum
+        qdc_charges.clear();
+        qdc_ids.clear();
+        double act_share[6], share_sum = 0;
+        for (int k = 0; k < 6; ++k) share_sum += (act_share[k] = rng.Uniform(0.5, 1.5));
+        bool t4_fired = rng.Rndm() < 0.95;
+        bool hole_fired = rng.Rndm() < 0.03;
+        for (int ch = 0; ch < 64; ++ch) {
+            double q = rng.Gaus(60, 10);
+            if (ch >= 18 && ch <= 23) q = act * act_share[ch - 18] / share_sum;
+            else if (ch == 42 || ch == 43) q = t4_fired ? rng.Gaus(900, 150) : rng.Gaus(100, 20);
+            else if (ch == 9 || ch == 10) q = hole_fired ? rng.Gaus(600, 50) : rng.Gaus(30, 5);
+            qdc_ids.push_back(ch);
+            qdc_charges.push_back((float)q);
+        }
+
+        // Beamline TDC: raw time = T0/T1 value + 250 ns, with the T0 value
+        // well below -100 ns as the tools expect
+        tdc_times.clear();
+        tdc_ids.clear();
+        double t0_value = rng.Gaus(-135, 3);
+        for (int ch = 0; ch < 8; ++ch) {
+            double t = t0_value + (ch >= 4 ? tof : 0) + rng.Gaus(0, 0.05);
+            tdc_ids.push_back(ch);
+            tdc_times.push_back((float)(t + 250.0));
+        }
+        int n_noise = rng.Poisson(3);
+        for (int k = 0; k < n_noise; ++k) {
+            tdc_ids.push_back(8 + (int)rng.Integer(56));
+            tdc_times.push_back((float)rng.Uniform(200, 600));
+        }
+
+        // Hit PMTs: Poisson hits on each mPMT card, then the beamline PMTs
+        // on cards 130-132 with the card 131 T0 references near 2200 ns
+        hit_mpmt_card_ids.clear();
+        hit_pmt_channel_ids.clear();
+        hit_mpmt_slot_ids.clear();
+        hit_pmt_position_ids.clear();
+        hit_pmt_charges.clear();
+        hit_pmt_times.clear();
+        double event_time = rng.Gaus(2600, 200);
+        for (int card = 0; card < n_cards; ++card) {
+            int n_hits = rng.Poisson(hits_per_card);
+            for (int h = 0; h < n_hits; ++h) {
+                int channel = (int)rng.Integer(19);
+                hit_mpmt_card_ids.push_back(card);
+                hit_pmt_channel_ids.push_back(channel);
+                hit_mpmt_slot_ids.push_back(card);
+                hit_pmt_position_ids.push_back(channel);
+                hit_pmt_charges.push_back((float)rng.Landau(150, 40));
+                hit_pmt_times.push_back(rng.Rndm() < 0.8 ? event_time + rng.Gaus(0, 5) : rng.Uniform(1000, 5000));
+            }
+        }
+        for (const auto& bh : beamline_hits) {
+            double t;
+            if (bh.card == 131 && bh.channel >= 12 && bh.channel <= 15) {
+                t = t0_hit_offset[bh.channel - 12] + rng.Gaus(0, 2);
+            } else {
+                t = 2200 + rng.Gaus(0, 5);
+                if (bh.index >= 4 && bh.index <= 7) t += tof;
+            }
+            hit_mpmt_card_ids.push_back(bh.card);
+            hit_pmt_channel_ids.push_back(bh.channel);
+            hit_mpmt_slot_ids.push_back(bh.card);
+            hit_pmt_position_ids.push_back(bh.channel);
+            hit_pmt_charges.push_back(qdc_charges[bh.index]);
+            hit_pmt_times.push_back(t);
+        }
+
+        // Optional waveforms: one pulse per hit
+        wf_card_ids.clear();
+        wf_channel_ids.clear();
+        wf_slot_ids.clear();
+        wf_position_ids.clear();
+        wf_times.clear();
+        wf_samples.resize(0);
+        if (waveforms) {
+            for (size_t h = 0; h < hit_pmt_times.size(); ++h) {
+                wf_card_ids.push_back(hit_mpmt_card_ids[h]);
+                wf_channel_ids.push_back(hit_pmt_channel_ids[h]);
+                wf_slot_ids.push_back(hit_mpmt_slot_ids[h]);
+                wf_position_ids.push_back(hit_pmt_position_ids[h]);
+                wf_times.push_back(hit_pmt_times[h] - 16);
+                std::vector<double> samples(kWaveformSamples);
+                double amplitude = hit_pmt_charges[h] / 4.0;
+                for (int s = 0; s < kWaveformSamples; ++s) {
+                    double x = s - 8;
+                    samples[s] = rng.Gaus(0, 1) + (x > 0 ? amplitude * x / 3.0 * std::exp(1 - x / 3.0) : 0);
+                }
+                wf_samples.push_back(std::move(samples));
+            }
+        }
+
+        tree->Fill();
+        progress.Add();
+    }
+    progress.Finish();
+
+    outfile->cd();
+    tree->Write();
+    outfile->Close();
+
+    std::cout << "Wrote " << n_events << " windows of run " << run_id << " to " << output << "\n";
+    std::cout << "Generated electrons: " << generated[0] << ", muons: " << generated[1]
+              << ", pions: " << generated[2] << ", other: " << generated[3] << "\n";
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "WCTE_HitIndex.h"
+#include <algorithm>
+
+void WCTE_HitIndex::Build(const std::vector<int>& card_ids) {
+    // Count hits per card, shifted by one so the prefix sum gives the offsets;
+    // the count table only grows when a higher card id shows up
+    int max_card = -1;
+    std::fill(counts_.begin(), counts_.end(), 0);
+    for (int card : card_ids) {
+        if (card < 0) continue;  // left out of the index
+        if (card + 2 > (int)counts_.size()) counts_.resize(card + 2, 0);
+        ++counts_[card + 1];
+        if (card > max_card) max_card = card;
+    }
+
+    // No indexable hits: counts_ may still be empty on the first event
+    if (max_card < 0) {
+        offsets_.assign(1, 0);
+        hits_.clear();
+        return;
+    }
+
+    offsets_.assign(counts_.begin(), counts_.begin() + (max_card + 2));
+    for (size_t c = 1; c < offsets_.size(); ++c) offsets_[c] += offsets_[c - 1];
+
+    hits_.resize(offsets_.back());
+    cursor_.assign(offsets_.begin(), offsets_.end() - 1);
+    for (size_t j = 0; j < card_ids.size(); ++j) {
+        int card = card_ids[j];
+        if (card >= 0) hits_[cursor_[card]++] = (int)j;
+    }
+}
+
+void WCTE_HitIndex::Clear() {
+    offsets_.assign(1, 0);
+    hits_.clear();
+}
@@ -0,0 +1,46 @@
+#ifndef WCTE_HITINDEX_H
+#define WCTE_HITINDEX_H
+
+#include <vector>
+#include <cstddef>
+
+// Hits of one readout window bucketed by card (compressed sparse row):
+// Build() does a counting sort of the hit positions by hit_mpmt_card_ids,
+// after which Card(c) gives the positions of the hits on card c, in their
+// original order, without scanning the other cards. Buffers are reused
+// from event to event.
+class WCTE_HitIndex {
+public:
+    // Positions into the hit_pmt_* vectors of the event
+    class Range {
+    public:
+        Range() = default;
+        Range(const int* b, const int* e) : begin_(b), end_(e) {}
+        const int* begin() const { return begin_; }
+        const int* end() const { return end_; }
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+    private:
+        const int* begin_ = nullptr;
+        const int* end_ = nullptr;
+    };
+
+    void Build(const std::vector<int>& card_ids);
+    void Clear();
+
+    Range Card(int card) const {
+        if (card < 0 || card + 1 >= (int)offsets_.size()) return Range();
+        return Range(hits_.data() + offsets_[card], hits_.data() + offsets_[card + 1]);
+    }
+
+    int MaxCard() const { return (int)offsets_.size() - 2; }  // -1 when empty
+    size_t Size() const { return hits_.size(); }
+
+private:
+    std::vector<int> offsets_{0};  // hits of card c are hits_[offsets_[c] .. offsets_[c + 1])
+    std::vector<int> counts_;   // per-card counts, kept at the largest card seen
+    std::vector<int> cursor_;
+    std::vector<int> hits_;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "WCTE_Log.h"
+#include <mutex>
+#include <vector>
+
+namespace {
+
+std::mutex& registryMutex() {
+    static std::mutex m;
+    return m;
+}
+
+std::vector<WCTE_LogReason*>& registry() {
+    static std::vector<WCTE_LogReason*> reasons;
+    return reasons;
+}
+
+} // namespace
+
+WCTE_LogReason::WCTE_LogReason(const char* name, int max_examples)
+    : name_(name), max_examples_(max_examples) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+}
+
+void WCTE_Log::PrintSummary(std::ostream& os) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    bool header = false;
+    for (const WCTE_LogReason* reason : registry()) {
+        if (reason->Get() == 0) continue;
+        if (!header) {
+            os << "Rejection summary:" << std::endl;
+            header = true;
+        }
+        os << "  " << reason->Name() << ": " << reason->Get() << std::endl;
+    }
+}
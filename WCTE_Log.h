@@ -0,0 +1,66 @@
+#ifndef WCTE_LOG_H
+#define WCTE_LOG_H
+
+#include <atomic>
+#include <iostream>
+#include <string>
+
+// Logging for event loops. Nothing here writes per event: a rejection is
+// counted on a WCTE_LogReason, only its first few occurrences are printed
+// as examples, and WCTE_Log::PrintSummary() reports the totals at the end
+// of the job.
+//
+// WCTE_LOG_LEVEL sets what is compiled in (-DWCTE_LOG_LEVEL=N):
+//   0  counters only, no example lines
+//   1  example lines for the first few occurrences of each reason (default)
+//   2  also WCTE_LOG_DEBUG messages, which are per event and slow
+#ifndef WCTE_LOG_LEVEL
+#define WCTE_LOG_LEVEL 1
+#endif
+
+// A counted reason for dropping a hit or event. Define one per reason at
+// file scope; it registers itself for the summary. Count() is a relaxed
+// atomic increment and safe from worker threads.
+class WCTE_LogReason {
+public:
+    explicit WCTE_LogReason(const char* name, int max_examples = 3);
+
+    // Counts one occurrence; true while it is one of the first max_examples
+    bool Count() {
+        return count_.fetch_add(1, std::memory_order_relaxed) < max_examples_;
+    }
+
+    const char* Name() const { return name_; }
+    long long Get() const { return count_.load(std::memory_order_relaxed); }
+    void Reset() { count_.store(0, std::memory_order_relaxed); }
+
+private:
+    const char* name_;
+    long long max_examples_;
+    std::atomic<long long> count_{0};
+};
+
+namespace WCTE_Log {
+    // Prints every reason with a non-zero count
+    void PrintSummary(std::ostream& os = std::cout);
+}
+
+// WCTE_LOG_EXAMPLE(reason, "ch=" << ch << " t=" << t) counts the reason and
+// prints the message for its first few occurrences
+#if WCTE_LOG_LEVEL >= 1
+#define WCTE_LOG_EXAMPLE(reason, msg)                                                    \
+    do {                                                                                 \
+        if ((reason).Count())                                                            \
+            std::cerr << "[" << (reason).Name() << "] " << msg << std::endl;             \
+    } while (0)
+#else
+#define WCTE_LOG_EXAMPLE(reason, msg) ((void)(reason).Count())
+#endif
+
+#if WCTE_LOG_LEVEL >= 2
+#define WCTE_LOG_DEBUG(msg) (std::cerr << "[DEBUG] " << msg << std::endl)
+#else
+#define WCTE_LOG_DEBUG(msg) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+#include "WCTE_Output.h"
+#include <TFile.h>
+#include <TParameter.h>
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+
+using json = nlohmann::json;
+
+bool WCTE_Output::ParseMode(const std::string& text, unsigned& mode) {
+    unsigned parsed = 0;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item == "pdf") parsed |= kPDF;
+        else if (item == "root") parsed |= kROOT;
+        else if (item == "json") parsed |= kJSON;
+        else {
+            std::cerr << "Unknown output mode: " << item << " (expected root, json or pdf)" << std::endl;
+            return false;
+        }
+    }
+    if (parsed == 0) return false;
+    mode = parsed;
+    return true;
+}
+
+WCTE_Output::WCTE_Output(const std::string& base, unsigned mode)
+    : base_(base), mode_(mode) {}
+
+void WCTE_Output::Add(TH1* h, const std::string& dir) {
+    if (h) hists_.emplace_back(dir, h);
+}
+
+void WCTE_Output::AddMetric(const std::string& name, double value) {
+    metrics_.emplace_back(name, value);
+}
+
+bool WCTE_Output::Write() const {
+    bool ok = true;
+    if (Has(kROOT)) ok = writeROOT(base_ + ".root") && ok;
+    if (Has(kJSON)) ok = writeJSON(base_ + ".json") && ok;
+    return ok;
+}
+
+bool WCTE_Output::writeROOT(const std::string& filename) const {
+    TFile* file = TFile::Open(filename.c_str(), "RECREATE");
+    if (!file || file->IsZombie()) {
+        std::cerr << "Cannot create " << filename << std::endl;
+        return false;
+    }
+
+    for (const auto& [dir, h] : hists_) {
+        TDirectory* target = file;
+        if (!dir.empty()) {
+            target = file->GetDirectory(dir.c_str());
+            if (!target) target = file->mkdir(dir.c_str());
+        }
+        target->WriteObject(h, h->GetName());
+    }
+
+    if (!metrics_.empty()) {
+        TDirectory* metrics_dir = file->mkdir("metrics");
+        for (const auto& [name, value] : metrics_) {
+            TParameter<double> p(name.c_str(), value);
+            metrics_dir->WriteObject(&p, name.c_str());
+        }
+    }
+
+    file->Close();
+    delete file;
+    std::cout << "Wrote " << filename << std::endl;
+    return true;
+}
+
+bool WCTE_Output::writeJSON(const std::string& filename) const {
+    // NaN (e.g. a fraction of zero events) is not valid JSON; it becomes null
+    auto number = [](double v) { return std::isfinite(v) ? json(v) : json(nullptr); };
+
+    json j;
+    j["metrics"] = json::object();
+    for (const auto& [name, value] : metrics_) j["metrics"][name] = number(value);
+
+    j["histograms"] = json::object();
+    for (const auto& [dir, h] : hists_) {
+        std::string key = dir.empty() ? h->GetName() : dir + "/" + h->GetName();
+        j["histograms"][key] = {
+            {"entries", h->GetEntries()},
+            {"mean", number(h->GetMean())},
+            {"rms", number(h->GetRMS())}
+        };
+    }
+
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Cannot create " << filename << std::endl;
+        return false;
+    }
+    out << j.dump(2) << std::endl;
+    std::cout << "Wrote " << filename << std::endl;
+    return true;
+}
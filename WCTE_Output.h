@@ -0,0 +1,48 @@
+#ifndef WCTE_OUTPUT_H
+#define WCTE_OUTPUT_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <TH1.h>
+
+// Products of a tool: histograms and scalar metrics (means, sigmas, PID
+// fractions, pass counts). The shared --output-mode option selects
+//   root  histograms and metrics in <base>.root
+//   json  metrics plus entries/mean/RMS of every histogram in <base>.json
+//   pdf   the tool's own report pages (the default)
+// or a comma-separated combination ("root,json"). ROOT products can be
+// drawn later, and in parallel, with WCTE_RenderPlots.
+class WCTE_Output {
+public:
+    enum Mode : unsigned {
+        kPDF  = 1u << 0,
+        kROOT = 1u << 1,
+        kJSON = 1u << 2
+    };
+
+    static bool ParseMode(const std::string& text, unsigned& mode);
+
+    WCTE_Output(const std::string& base, unsigned mode = kPDF);
+
+    bool Has(Mode m) const { return (mode_ & m) != 0; }
+    const std::string& GetBase() const { return base_; }
+
+    // dir is a subdirectory of the ROOT file and a prefix in the JSON ("channels/h_qdc_ch3")
+    void Add(TH1* h, const std::string& dir = "");
+    void AddMetric(const std::string& name, double value);
+
+    // Writes the ROOT and JSON products of the mode; false if one could not be written
+    bool Write() const;
+
+private:
+    bool writeROOT(const std::string& filename) const;
+    bool writeJSON(const std::string& filename) const;
+
+    std::string base_;
+    unsigned mode_;
+    std::vector<std::pair<std::string, TH1*>> hists_;
+    std::vector<std::pair<std::string, double>> metrics_;
+};
+
+#endif
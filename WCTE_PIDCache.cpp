@@ -0,0 +1,155 @@
+#include "WCTE_PIDCache.h"
+#include "WCTE_AtomicFile.h"
+#include <TFile.h>
+#include <TObjArray.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char kMagic[8] = {'W', 'C', 'T', 'E', 'P', 'I', 'D', 'C'};
+const uint32_t kVersion = 2;
+
+// FNV-1a, enough to tell configurations apart
+void hashBytes(uint64_t& h, const void* data, size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+}
+
+void hashString(uint64_t& h, const std::string& s) {
+    hashBytes(h, s.data(), s.size());
+    hashBytes(h, "\0", 1);
+}
+
+template <typename T>
+void writeColumn(std::ostream& out, const std::vector<T>& v) {
+    out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+void readColumn(std::ifstream& in, std::vector<T>& v, size_t n) {
+    v.resize(n);
+    in.read(reinterpret_cast<char*>(v.data()), n * sizeof(T));
+}
+
+} // namespace
+
+uint64_t WCTE_PIDCache::MakeKey(TChain* chain, Long64_t n_entries,
+                                const WCTE_Config& config, const WCTE_ChannelMap& channel_map) {
+    uint64_t h = 14695981039346656037ull;
+    hashBytes(h, &kVersion, sizeof(kVersion));
+    hashBytes(h, &n_entries, sizeof(n_entries));
+
+    // Input files: path, size and mtime from the file system, UUID from the file header
+    TObjArray* files = chain ? chain->GetListOfFiles() : nullptr;
+    for (int i = 0; files && i < files->GetEntries(); ++i) {
+        std::string path = files->At(i)->GetTitle();
+        hashString(h, path);
+
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(path, ec);
+        if (ec) size = 0;
+        int64_t mtime = 0;
+        auto t = std::filesystem::last_write_time(path, ec);
+        if (!ec) mtime = t.time_since_epoch().count();
+        hashBytes(h, &size, sizeof(size));
+        hashBytes(h, &mtime, sizeof(mtime));
+
+        TFile* f = TFile::Open(path.c_str());
+        if (f && !f->IsZombie()) hashString(h, f->GetUUID().AsString());
+        delete f;
+    }
+
+    // Only the "box" sections change the cached PID codes
+    config.ForEachBox([&](int first, int last, const WCTE_Config::Box& box) {
+        hashBytes(h, &first, sizeof(first));
+        hashBytes(h, &last, sizeof(last));
+        hashBytes(h, box.cuts, sizeof(box.cuts));
+    });
+
+    for (int ch = 0; ch < WCTE_ChannelMap::kMaxChannels; ++ch) {
+        uint8_t role = channel_map.GetRole(ch);
+        hashBytes(h, &role, 1);
+    }
+    return h;
+}
+
+bool WCTE_PIDCache::Load(const std::string& cache_file, uint64_t key) {
+    std::ifstream in(cache_file, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    char magic[8];
+    uint32_t version = 0;
+    uint64_t file_key = 0, n = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&file_key), sizeof(file_key));
+    in.read(reinterpret_cast<char*>(&n), sizeof(n));
+    if (!in || !std::equal(magic, magic + 8, kMagic) || version != kVersion) {
+        std::cerr << "Ignoring unreadable PID cache " << cache_file << std::endl;
+        return false;
+    }
+    if (file_key != key) {
+        std::cerr << "PID cache " << cache_file << " is out of date, rebuilding." << std::endl;
+        return false;
+    }
+
+    readColumn(in, run_id, n);
+    readColumn(in, t0_avg, n);
+    readColumn(in, t1_avg, n);
+    readColumn(in, tof, n);
+    readColumn(in, act, n);
+    readColumn(in, flags, n);
+    readColumn(in, pid, n);
+    if (!in) {
+        std::cerr << "PID cache " << cache_file << " is truncated, rebuilding." << std::endl;
+        Resize(0);
+        return false;
+    }
+    return true;
+}
+
+bool WCTE_PIDCache::Save(const std::string& cache_file, uint64_t key) const {
+    bool ok = WCTE_WriteFileAtomic(cache_file, [&](std::ostream& out) {
+        uint64_t n = Size();
+        out.write(kMagic, sizeof(kMagic));
+        out.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+        out.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        writeColumn(out, run_id);
+        writeColumn(out, t0_avg);
+        writeColumn(out, t1_avg);
+        writeColumn(out, tof);
+        writeColumn(out, act);
+        writeColumn(out, flags);
+        writeColumn(out, pid);
+    });
+    if (!ok) std::cerr << "Cannot write PID cache " << cache_file << std::endl;
+    return ok;
+}
+
+void WCTE_PIDCache::Resize(size_t n) {
+    run_id.assign(n, 0);
+    t0_avg.assign(n, -999);
+    t1_avg.assign(n, -999);
+    tof.assign(n, -999);
+    act.assign(n, -1);
+    flags.assign(n, 0);
+    pid.assign(n, 0);
+}
+
+void WCTE_PIDCache::Set(size_t i, int run, const WCTE_BeamMon_PID& pid_tool, int pid_code) {
+    const auto& s = pid_tool.GetBeamlineSummary();
+    run_id[i] = run;
+    t0_avg[i] = s.t0_avg;
+    t1_avg[i] = s.t1_avg;
+    tof[i] = pid_tool.GetTofT0T1();
+    act[i] = pid_tool.GetActGroup2Sum();
+    flags[i] = (s.has_qdc ? kHasQDC : 0) | (s.t4_hit ? kT4Hit : 0) | (s.hole0 ? kHole0 : 0) |
+               (s.hole1 ? kHole1 : 0) | (s.passes_cuts ? kPassesCuts : 0);
+    pid[i] = static_cast<int16_t>(pid_code);
+}
@@ -0,0 +1,47 @@
+#ifndef WCTE_PIDCACHE_H
+#define WCTE_PIDCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <TChain.h>
+#include "WCTE_BeamMon_PID.h"
+
+// On-disk cache of the per-entry beamline summary and PID code.
+// The key covers the input files (path, size, mtime, UUID), the number of
+// entries, the "box" cuts of the configuration and the channel roles, so a cache
+// written for other inputs or other cuts is never reused. Data quality is
+// not part of the key; it is applied when the cache is replayed.
+class WCTE_PIDCache {
+public:
+    enum Flag : uint8_t {
+        kHasQDC     = 1u << 0,
+        kT4Hit      = 1u << 1,
+        kHole0      = 1u << 2,
+        kHole1      = 1u << 3,
+        kPassesCuts = 1u << 4
+    };
+
+    static uint64_t MakeKey(TChain* chain, Long64_t n_entries,
+                            const WCTE_Config& config, const WCTE_ChannelMap& channel_map);
+
+    // Returns false if the file is missing, unreadable or has another key
+    bool Load(const std::string& cache_file, uint64_t key);
+    bool Save(const std::string& cache_file, uint64_t key) const;
+
+    void Resize(size_t n);
+    size_t Size() const { return run_id.size(); }
+
+    // Stores the summary currently held by pid as entry i. Distinct entries
+    // may be set from different threads.
+    void Set(size_t i, int run, const WCTE_BeamMon_PID& pid, int pid_code);
+
+    // One column per quantity
+    std::vector<int>     run_id;
+    std::vector<float>   t0_avg, t1_avg;
+    std::vector<double>  tof, act;    // as returned by GetTofT0T1() / GetActGroup2Sum()
+    std::vector<uint8_t> flags;
+    std::vector<int16_t> pid;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "WCTE_PointSample.h"
+#include <algorithm>
+
+namespace {
+
+// splitmix64 finaliser: a bijection, so distinct keys never tie
+uint64_t mix(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+void WCTE_PointSample::SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+    while (heap_.size() > capacity_) {
+        std::pop_heap(heap_.begin(), heap_.end());
+        heap_.pop_back();
+    }
+}
+
+void WCTE_PointSample::push(const Point& p) {
+    if (heap_.size() < capacity_) {
+        heap_.push_back(p);
+        std::push_heap(heap_.begin(), heap_.end());
+    } else if (capacity_ > 0 && p.priority < heap_.front().priority) {
+        std::pop_heap(heap_.begin(), heap_.end());
+        heap_.back() = p;
+        std::push_heap(heap_.begin(), heap_.end());
+    }
+}
+
+void WCTE_PointSample::Add(uint64_t key, double x, double y) {
+    ++seen_;
+    push({mix(key), x, y});
+}
+
+void WCTE_PointSample::Merge(const WCTE_PointSample& other) {
+    seen_ += other.seen_;
+    for (const Point& p : other.heap_) push(p);
+}
+
+TGraph* WCTE_PointSample::ToTGraph() const {
+    std::vector<Point> points(heap_);
+    std::sort(points.begin(), points.end());
+
+    TGraph* g = new TGraph((int)points.size());
+    for (size_t i = 0; i < points.size(); ++i) g->SetPoint((int)i, points[i].x, points[i].y);
+    return g;
+}
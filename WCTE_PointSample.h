@@ -0,0 +1,40 @@
+#ifndef WCTE_POINTSAMPLE_H
+#define WCTE_POINTSAMPLE_H
+
+#include <cstdint>
+#include <vector>
+#include <TGraph.h>
+
+// Bounded sample of (x, y) points for scatter overlays. Every point comes
+// with a key (the entry number) and the points with the smallest hashed keys
+// are kept, so the sample is the same whatever the fill order or the split
+// of entries over threads, and Merge() of per-thread samples is exact.
+class WCTE_PointSample {
+public:
+    explicit WCTE_PointSample(size_t capacity = 50000) : capacity_(capacity) {}
+
+    void SetCapacity(size_t capacity);
+    void Add(uint64_t key, double x, double y);
+    void Merge(const WCTE_PointSample& other);
+
+    size_t Size() const { return heap_.size(); }
+    uint64_t GetSeen() const { return seen_; }  // points offered, kept or not
+
+    // New TGraph (owned by the caller) with the kept points in key-hash order
+    TGraph* ToTGraph() const;
+
+private:
+    struct Point {
+        uint64_t priority;
+        double x, y;
+        bool operator<(const Point& o) const { return priority < o.priority; }
+    };
+
+    void push(const Point& p);
+
+    size_t capacity_;
+    uint64_t seen_ = 0;
+    std::vector<Point> heap_;  // max-heap on priority, at most capacity_ points
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "WCTE_Progress.h"
+#include <iostream>
+#include <cstdio>
+
+WCTE_Progress::WCTE_Progress(const std::string& label, Long64_t total, double interval_s)
+    : label_(label), total_(total), start_(Clock::now()),
+      interval_(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval_s))) {
+    next_report_ = (start_ + interval_).time_since_epoch().count();
+}
+
+void WCTE_Progress::Add(Long64_t n) {
+    Long64_t done = done_.fetch_add(n, std::memory_order_relaxed) + n;
+    if (done / 4096 == (done - n) / 4096) return;
+
+    Clock::time_point now = Clock::now();
+    Clock::rep next = next_report_.load(std::memory_order_relaxed);
+    if (now.time_since_epoch().count() < next) return;
+
+    // Only the thread that moves the deadline prints
+    Clock::rep new_next = (now + interval_).time_since_epoch().count();
+    if (!next_report_.compare_exchange_strong(next, new_next)) return;
+
+    print(done, std::chrono::duration<double>(now - start_).count());
+}
+
+void WCTE_Progress::Finish() {
+    double elapsed = std::chrono::duration<double>(Clock::now() - start_).count();
+    print(done_.load(), elapsed);
+}
+
+void WCTE_Progress::print(Long64_t done, double elapsed_s) const {
+    double rate = elapsed_s > 0 ? done / elapsed_s : 0;
+    double percent = total_ > 0 ? 100.0 * done / total_ : 100.0;
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "[%s] %lld / %lld entries (%.1f%%), %.1f s, %.0f events/s",
+                  label_.c_str(), (long long)done, (long long)total_, percent, elapsed_s, rate);
+    std::cout << line << std::endl;
+}
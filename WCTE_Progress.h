@@ -0,0 +1,39 @@
+#ifndef WCTE_PROGRESS_H
+#define WCTE_PROGRESS_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <Rtypes.h>
+
+// Progress and throughput report for event loops. Add() is cheap (the clock
+// is looked at every 4096 entries) and may be called from several threads;
+// a line with entries done, percentage and events/s is printed every few
+// seconds, and Finish() prints the totals.
+class WCTE_Progress {
+public:
+    WCTE_Progress(const std::string& label, Long64_t total, double interval_s = 10.0);
+
+    void Add(Long64_t n = 1);
+    void Finish();
+
+    // Entries to process: all of them, or at most max_events if it is >= 0
+    // (the value of a tool's --max-events option, -1 when not given)
+    static Long64_t Limit(Long64_t available, Long64_t max_events) {
+        return (max_events >= 0 && max_events < available) ? max_events : available;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void print(Long64_t done, double elapsed_s) const;
+
+    std::string label_;
+    Long64_t total_;
+    Clock::time_point start_;
+    Clock::duration interval_;
+    std::atomic<Long64_t> done_{0};
+    std::atomic<Clock::rep> next_report_;
+};
+
+#endif
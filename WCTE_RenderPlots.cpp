@@ -0,0 +1,103 @@
+// WCTE_RenderPlots.cpp
+//
+// Draws the histograms of a ROOT product written with --output-mode root
+// into a PDF, so report rendering is a separate step from the event loop.
+// Products are independent; render several at once, e.g.
+//   ls *.root | xargs -P 8 -n 1 ./WCTE_RenderPlots
+
+#include <TFile.h>
+#include <TKey.h>
+#include <TList.h>
+#include <TH1.h>
+#include <TH2.h>
+#include <TCanvas.h>
+#include <TText.h>
+#include <TROOT.h>
+#include <TSystem.h>
+#include <TString.h>
+#include <iostream>
+#include <vector>
+#include <string>
+
+namespace {
+
+// Histograms of dir and its subdirectories, in key order; the metrics
+// directory only holds TParameters and contributes nothing
+void CollectHistograms(TDirectory* dir, std::vector<TH1*>& out) {
+    TIter next(dir->GetListOfKeys());
+    while (TKey* key = (TKey*)next()) {
+        TObject* obj = key->ReadObj();
+        if (TDirectory* sub = dynamic_cast<TDirectory*>(obj)) {
+            CollectHistograms(sub, out);
+        } else if (TH1* h = dynamic_cast<TH1*>(obj)) {
+            out.push_back(h);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    int per_page = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--per-page" && i + 1 < argc) {
+            per_page = std::stoi(argv[++i]);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty() || (per_page != 1 && per_page != 2 && per_page != 4)) {
+        std::cerr << "Usage: " << argv[0] << " <product.root> [output.pdf] [--per-page 1|2|4]" << std::endl;
+        return 1;
+    }
+
+    std::string input = args[0];
+    std::string output_pdf = args.size() > 1 ? args[1] : input.substr(0, input.rfind(".root")) + ".pdf";
+
+    gROOT->SetBatch(true);
+
+    TFile* file = TFile::Open(input.c_str());
+    if (!file || file->IsZombie()) {
+        std::cerr << "Error opening " << input << std::endl;
+        return 1;
+    }
+
+    std::vector<TH1*> hists;
+    CollectHistograms(file, hists);
+    if (hists.empty()) {
+        std::cerr << "No histograms in " << input << std::endl;
+        return 1;
+    }
+
+    TCanvas* c = new TCanvas("c", "Products", 1000, 800);
+    c->Print((output_pdf + "(").c_str());
+
+    c->Clear();
+    TText* title = new TText(0.5, 0.6, gSystem->BaseName(input.c_str()));
+    title->SetTextAlign(22);
+    title->SetTextSize(0.04);
+    title->Draw();
+    c->Print(output_pdf.c_str());
+
+    for (size_t first = 0; first < hists.size(); first += per_page) {
+        c->Clear();
+        if (per_page == 2) c->Divide(1, 2);
+        if (per_page == 4) c->Divide(2, 2);
+
+        for (int k = 0; k < per_page && first + k < hists.size(); ++k) {
+            c->cd(per_page == 1 ? 0 : k + 1);
+            TH1* h = hists[first + k];
+            h->Draw(dynamic_cast<TH2*>(h) ? "colz" : "hist");
+        }
+        c->Print(output_pdf.c_str());
+    }
+
+    c->Print((output_pdf + ")").c_str());
+    std::cout << "Rendered " << hists.size() << " histograms to " << output_pdf << std::endl;
+
+    file->Close();
+    return 0;
+}
@@ -0,0 +1,90 @@
+#ifndef WCTE_RUNINDEX_H
+#define WCTE_RUNINDEX_H
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Run number -> value lookup for boxcuts.json entries.
+// Keys are single runs ("1670") or inclusive ranges ("1600-1699").
+// A single-run entry overrides any range containing it; ranges must not
+// overlap each other. Lookups are a binary search over sorted intervals.
+template <typename T>
+class WCTE_RunIndex {
+public:
+    static bool ParseRunKey(const std::string& key, int& first, int& last) {
+        try {
+            size_t pos = 0;
+            first = std::stoi(key, &pos);
+            if (pos == key.size()) {
+                last = first;
+                return true;
+            }
+            if (key[pos] != '-') return false;
+            std::string rest = key.substr(pos + 1);
+            last = std::stoi(rest, &pos);
+            return pos == rest.size() && last >= first;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool Insert(int first, int last, const T& value) {
+        std::vector<Interval>& table = (first == last) ? runs_ : ranges_;
+        auto it = std::lower_bound(table.begin(), table.end(), first,
+                                   [](const Interval& iv, int run) { return iv.first < run; });
+
+        if (first == last) {
+            if (it != table.end() && it->first == first) {
+                it->value = value;
+                return true;
+            }
+        } else {
+            bool overlaps = (it != table.end() && it->first <= last) ||
+                            (it != table.begin() && std::prev(it)->last >= first);
+            if (overlaps) {
+                std::cerr << "Run range " << first << "-" << last
+                          << " overlaps another range, ignored." << std::endl;
+                return false;
+            }
+        }
+        table.insert(it, Interval{first, last, value});
+        return true;
+    }
+
+    const T* Find(int run_id) const {
+        if (const T* v = find(runs_, run_id)) return v;
+        return find(ranges_, run_id);
+    }
+
+    bool Empty() const { return runs_.empty() && ranges_.empty(); }
+
+    // Calls f(first, last, value) for the single runs, then the ranges, each sorted
+    template <typename F>
+    void ForEach(F&& f) const {
+        for (const Interval& iv : runs_) f(iv.first, iv.last, iv.value);
+        for (const Interval& iv : ranges_) f(iv.first, iv.last, iv.value);
+    }
+
+private:
+    struct Interval {
+        int first, last;
+        T value;
+    };
+
+    static const T* find(const std::vector<Interval>& table, int run_id) {
+        auto it = std::upper_bound(table.begin(), table.end(), run_id,
+                                   [](int run, const Interval& iv) { return run < iv.first; });
+        if (it == table.begin()) return nullptr;
+        --it;
+        return (run_id <= it->last) ? &it->value : nullptr;
+    }
+
+    std::vector<Interval> runs_;    // single runs, sorted
+    std::vector<Interval> ranges_;  // run ranges, sorted and disjoint
+};
+
+#endif
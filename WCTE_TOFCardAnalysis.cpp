@@ -2,11 +2,11 @@
 
 #include <TFile.h>
 #include <TTree.h>
+#include <TChain.h>
 #include <TCanvas.h>
 #include <TH1D.h>
 #include <TH2D.h>
 #include <TGraph.h>
-#include <TF1.h>
 #include <TLegend.h>
 #include <TText.h>
 #include <TSystem.h>
@@ -15,59 +15,179 @@
 #include <vector>
 #include <map>
 #include <cmath>
+#include <cstdint>
 #include "WCTE_BeamMon_PID.h"
+#include "WCTE_EventReader.h"
+#include "WCTE_Log.h"
+#include "WCTE_Output.h"
+#include "WCTE_Progress.h"
+#include "WCTE_Utility.h"
+
+namespace {
+
+const int kMaxMPMTCard = 129;  // cards 130-132 carry the beamline and T0 PMTs
+
+// Hits of one card inside the 1000-5000 ns window
+struct CardSums {
+    double time_sum = 0;
+    double min_time = 1e9;
+    double qdc_sum = 0;
+    int hits = 0;
+};
+
+CardSums SumCard(const WCTE_EventReader& reader, int card) {
+    CardSums s;
+    for (int j : reader.hit_index.Card(card)) {
+        double t = (*reader.hit_pmt_times)[j];
+        if (t > 1000 && t < 5000) {
+            s.time_sum += t;
+            s.qdc_sum += (*reader.hit_pmt_charges)[j];
+            s.hits++;
+            if (t < s.min_time) s.min_time = t;
+        }
+    }
+    return s;
+}
 
-int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file> <boxcuts.json>" << std::endl;
-        return 1;
+// Events reduced to what the ToF fill needs, column-wise. T0 hits and
+// card sums of event e are [X_begin(e), X_end[e]).
+struct EventBuffer {
+    std::vector<int> pid;
+    std::vector<size_t> t0_end;
+    std::vector<int8_t> t0_k;         // index into the four T0 channels
+    std::vector<double> t0_time;
+    std::vector<size_t> card_end;
+    std::vector<int16_t> card;
+    std::vector<double> time_sum, min_time, qdc_sum;
+    std::vector<int> hits;
+
+    size_t Size() const { return pid.size(); }
+    size_t t0_begin(size_t e) const { return e == 0 ? 0 : t0_end[e - 1]; }
+    size_t card_begin(size_t e) const { return e == 0 ? 0 : card_end[e - 1]; }
+
+    void BeginEvent(int pid_code) { pid.push_back(pid_code); }
+    void AddT0Hit(int k, double t) { t0_k.push_back(k); t0_time.push_back(t); }
+    void AddCard(int c, const CardSums& s) {
+        card.push_back(c);
+        time_sum.push_back(s.time_sum);
+        min_time.push_back(s.min_time);
+        qdc_sum.push_back(s.qdc_sum);
+        hits.push_back(s.hits);
     }
+    void EndEvent() { t0_end.push_back(t0_time.size()); card_end.push_back(card.size()); }
 
-    const int selected_card = 31;
-    std::string filename = argv[1];
-    std::string boxcutfile = argv[2];
+    CardSums Sums(size_t c) const { return {time_sum[c], min_time[c], qdc_sum[c], hits[c]}; }
 
-    std::string base = gSystem->BaseName(filename.c_str());
-    size_t pos1 = base.find("R");
-    size_t pos2 = base.find("S");
-    int run_id = (pos1 != std::string::npos && pos2 != std::string::npos && pos2 > pos1) ?
-                 std::stoi(base.substr(pos1 + 1, pos2 - pos1 - 1)) : 0;
+    void Clear() {
+        pid.clear();
+        t0_end.clear(); t0_k.clear(); t0_time.clear();
+        card_end.clear(); card.clear();
+        time_sum.clear(); min_time.clear(); qdc_sum.clear(); hits.clear();
+    }
+};
+
+// --all-cards: per-card running sums for the summary histograms, and
+// ToF / min-time ToF / QDC histograms per card for all events and per PID.
+// Index 0 of each histogram array is "all", then electron, muon, pion.
+struct CardAccumulator {
+    Long64_t n = 0;
+    double tof_sum = 0, tof_sum2 = 0;
+    double tof_min_sum = 0;
+    double qdc_sum = 0;
+
+    TH1D* h_tof[4] = {nullptr};
+    TH1D* h_tof_min[4] = {nullptr};
+    TH1D* h_qdc[4] = {nullptr};
+};
+
+const int kPIDCodes[4] = {0, 11, 13, 211};
+const char* kPIDSuffix[4] = {"", "_electron", "_muon", "_pion"};
+
+void BookCard(CardAccumulator& acc, int card) {
+    for (int p = 0; p < 4; ++p) {
+        acc.h_tof[p] = new TH1D(Form("h_tof_card%d%s", card, kPIDSuffix[p]),
+                                Form("ToF Card %d%s;ToF (ns);Counts", card, kPIDSuffix[p]), 200, -1010, -970);
+        acc.h_tof_min[p] = new TH1D(Form("h_tof_min_card%d%s", card, kPIDSuffix[p]),
+                                    Form("ToF (Min Time) Card %d%s;ToF (ns);Counts", card, kPIDSuffix[p]), 200, -1010, -970);
+        acc.h_qdc[p] = new TH1D(Form("h_qdc_card%d%s", card, kPIDSuffix[p]),
+                                Form("QDC Sum Card %d%s;QDC;Counts", card, kPIDSuffix[p]), 2000, 0, 14000);
+        for (TH1D* h : {acc.h_tof[p], acc.h_tof_min[p], acc.h_qdc[p]}) h->SetDirectory(nullptr);
+    }
+}
+
+} // namespace
 
-    TString output_pdf = Form("tof_qdc_analysis_run%d_card%d.pdf", run_id, selected_card);
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    Long64_t max_events = -1;
+    std::string index_file, index_pdg, mapping_file;
+    int selected_card = 31;
+    bool all_cards = false;
+    bool config_cache = false;
+    unsigned output_mode = WCTE_Output::kPDF;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else if (arg == "--config-cache") {
+            config_cache = true;
+        } else if (arg == "--output-mode" && i + 1 < argc) {
+            if (!WCTE_Output::ParseMode(argv[++i], output_mode)) return 1;
+        } else if (arg == "--card" && i + 1 < argc) {
+            selected_card = std::stoi(argv[++i]);
+        } else if (arg == "--all-cards") {
+            all_cards = true;
+        } else if (arg == "--index" && i + 1 < argc) {
+            index_file = argv[++i];
+        } else if (arg == "--pdg" && i + 1 < argc) {
+            index_pdg = argv[++i];
+        } else if (arg == "--mapping" && i + 1 < argc) {
+            mapping_file = argv[++i];
+        } else {
+            args.push_back(arg);
+        }
+    }
 
-    TFile* file = TFile::Open(filename.c_str());
-    if (!file || file->IsZombie()) {
-        std::cerr << "Error opening BRB file: " << filename << std::endl;
+    if (args.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file|glob> [more files...] <boxcuts.json> [--card N | --all-cards] [--max-events N] [--index <pidindex.root> --pdg <code>] [--output-mode root|json|pdf] [--config-cache] [--mapping <detector_mapping.txt>]" << std::endl;
         return 1;
     }
+    if (!index_file.empty() && index_pdg.empty()) {
+        std::cerr << "--index needs --pdg to pick the species entry list." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> inputs(args.begin(), args.end() - 1);
+    std::string boxcutfile = args.back();
 
-    TTree* tree = (TTree*)file->Get("WCTEReadoutWindows");
+    TChain* tree = WCTE_EventReader::MakeChain(inputs);
     if (!tree) {
-        std::cerr << "Tree 'WCTEReadoutWindows' not found!" << std::endl;
+        std::cerr << "Error opening BRB files." << std::endl;
         return 1;
     }
 
-    std::vector<int>* hit_card_ids = nullptr;
-    std::vector<int>* hit_channel_ids = nullptr;
-    std::vector<double>* hit_times = nullptr;
-    std::vector<float>* hit_qdc = nullptr;
-    std::vector<float>* beam_qdc = nullptr;
-    std::vector<int>* beam_qdc_ids = nullptr;
-    std::vector<float>* beam_tdc = nullptr;
-    std::vector<int>* beam_tdc_ids = nullptr;
-
-    tree->SetBranchAddress("hit_mpmt_card_ids", &hit_card_ids);
-    tree->SetBranchAddress("hit_pmt_channel_ids", &hit_channel_ids);
-    tree->SetBranchAddress("hit_pmt_times", &hit_times);
-    tree->SetBranchAddress("hit_pmt_charges", &hit_qdc);
-    tree->SetBranchAddress("beamline_pmt_qdc_charges", &beam_qdc);
-    tree->SetBranchAddress("beamline_pmt_qdc_ids", &beam_qdc_ids);
-    tree->SetBranchAddress("beamline_pmt_tdc_times", &beam_tdc);
-    tree->SetBranchAddress("beamline_pmt_tdc_ids", &beam_tdc_ids);
+    WCTE_EventReader reader(tree, WCTE_EventReader::kBeamline | WCTE_EventReader::kHitPMT);
+
+    // With a PID index only the chosen species is analysed; the T0 warm-up
+    // still reads the unfiltered input (GetTreeEntry below)
+    if (!index_file.empty() && !reader.SetEntryList(index_file, "elist_" + index_pdg)) return 1;
+
+    // Run number of the first event names the output; cuts follow run_id per event
+    reader.GetEntry(0);
+    int run_id = reader.run_id;
+
+    // The all-cards survey has no PDF report; its default product is the ROOT file
+    if (all_cards && (output_mode & WCTE_Output::kPDF))
+        output_mode = (output_mode & ~WCTE_Output::kPDF) | WCTE_Output::kROOT;
+    WCTE_Output output(all_cards ? Form("tof_qdc_analysis_run%d_allcards", run_id)
+                                 : Form("tof_qdc_analysis_run%d_card%d", run_id, selected_card), output_mode);
+    TString output_pdf = (output.GetBase() + ".pdf").c_str();
 
     WCTE_BeamMon_PID pid;
-    pid.LoadBoxCuts(boxcutfile);
+    if (!pid.LoadBoxCuts(boxcutfile, config_cache ? WCTE_Config::DefaultCacheFile(boxcutfile) : "")) return 1;
+    if (!pid.SetupChannelMap(mapping_file)) return 1;
     pid.SetRunID(run_id);
+    if (!pid.SetPIDMethod("box")) return 1;
 
     const int t0_ch[4] = {12, 13, 14, 15};
     TH1D* h_t0_ch[4];
@@ -75,31 +195,6 @@ int main(int argc, char* argv[]) {
         h_t0_ch[i] = new TH1D(Form("h_t0_ch%d", t0_ch[i]), Form("Card 131 Ch %d;Time (ns);Counts", t0_ch[i]), 200, 2150, 2250);
     TH1D* h_selected_all = new TH1D("h_selected_all", "All Hit Times on Selected Card;Time (ns);Counts", 200, 1000, 5000);
 
-    Long64_t nEntries = std::min(tree->GetEntries(), (Long64_t)5000);
-    for (Long64_t i = 0; i < nEntries; ++i) {
-        tree->GetEntry(i);
-        for (size_t j = 0; j < hit_card_ids->size(); ++j) {
-            int card = (*hit_card_ids)[j];
-            int ch = (*hit_channel_ids)[j];
-            double t = (*hit_times)[j];
-            if (card == 131) {
-                for (int k = 0; k < 4; ++k)
-                    if (ch == t0_ch[k]) h_t0_ch[k]->Fill(t);
-            }
-            if (card == selected_card)
-                h_selected_all->Fill(t);
-        }
-    }
-
-    double t0_mean[4], t0_sigma[4];
-    for (int i = 0; i < 4; ++i) {
-        TF1* g = new TF1(Form("gfit_%d", i), "gaus", 2150, 2250);
-        g->SetParameters(h_t0_ch[i]->GetMaximum(), 2200, 5);
-        h_t0_ch[i]->Fit(g, "RQ");
-        t0_mean[i] = g->GetParameter(1);
-        t0_sigma[i] = g->GetParameter(2);
-    }
-
     TH1D* h_tof = new TH1D("h_tof", "ToF (All);ToF (ns);Counts", 200, -1010, -970);
     TH1D* h_qdc = new TH1D("h_qdc", "QDC Sum (All);QDC;Counts", 2000, 0, 14000);
     TH2D* h_qdc_vs_tof = new TH2D("h_qdc_vs_tof", "QDC vs ToF (All);ToF (ns);QDC", 200, -1010, -970, 2000, 0, 14000);
@@ -128,61 +223,243 @@ int main(int argc, char* argv[]) {
         h_qdc_vs_tof_pid_min[pid_code] = new TH2D(Form("h_qdc_vs_tof_min_%s", name.Data()), "", 200, -1010, -970, 2000, 0, 14000);
     }
 
-    nEntries = std::min(tree->GetEntries(), (Long64_t)500000);
-    for (Long64_t i = 0; i < nEntries; ++i) {
-        tree->GetEntry(i);
-        pid.SetBeamlineData(beam_qdc, beam_qdc_ids, beam_tdc, beam_tdc_ids);
-        int pid_code = pid.GetParticleID();
-
-        double t0_sum = 0; int t0_hits = 0;
-        double card_sum = 0; int card_hits = 0;
-        double qdc_sum = 0;
-        double min_time = 1e9;
-
-        for (size_t j = 0; j < hit_card_ids->size(); ++j) {
-            int card = (*hit_card_ids)[j];
-            int ch = (*hit_channel_ids)[j];
-            double t = (*hit_times)[j];
-            double q = (*hit_qdc)[j];
-
-            if (card == 131) {
-                for (int k = 0; k < 4; ++k)
-                    if (ch == t0_ch[k] && fabs(t - t0_mean[k]) < 3 * t0_sigma[k]) {
-                        t0_sum += t;
-                        t0_hits++;
+    std::vector<CardAccumulator> cards(all_cards ? kMaxMPMTCard + 1 : 0);
+
+    // The ToF cut needs the T0 calibration, which converges on the first
+    // events. Each event is reduced to its T0 hits, per-card sums and PID
+    // code; while calibrating these wait in the buffer, afterwards the
+    // buffer is drained every event, so the tree is read only once. A dead
+    // or noisy T0 channel never fills its warm-up, so the buffer is also
+    // capped in events: at the cap the calibration is fixed from what it has.
+    // The warm-up is counted in T0 hits per channel (about one per event),
+    // where the earlier histogram fit used the first 5000 events.
+    const size_t n_calibration_hits = 5000;
+    const size_t n_calibration_max_events = 20000;
+    WCTE_Utility util;
+    util.SetCalibrationHits(n_calibration_hits);
+    EventBuffer buffer;
+
+    // Feeds the current event to the T0 calibration and its monitoring
+    // histograms; true once the calibration is fixed
+    auto warmup = [&]() {
+        for (int j : reader.hit_index.Card(131)) {
+            int ch = (*reader.hit_pmt_channel_ids)[j];
+            for (int k = 0; k < 4; ++k) {
+                if (ch == t0_ch[k]) {
+                    h_t0_ch[k]->Fill((*reader.hit_pmt_times)[j]);
+                    break;
+                }
+            }
+        }
+        for (int j : reader.hit_index.Card(selected_card))
+            h_selected_all->Fill((*reader.hit_pmt_times)[j]);
+
+        util.SetHitPMTData(reader.hit_mpmt_card_ids, reader.hit_pmt_channel_ids,
+                           reader.hit_pmt_times, &reader.hit_index);
+        return util.AddCalibrationHits();
+    };
+
+    // With --index the warm-up takes the first entries of the input chain,
+    // all species, as it does without an index; the loop then never buffers
+    if (!index_file.empty()) {
+        Long64_t n_warmup = std::min<Long64_t>(tree->GetEntries(), n_calibration_max_events);
+        for (Long64_t i = 0; i < n_warmup && !util.CalibrationFailed(); ++i) {
+            reader.GetTreeEntry(i);
+            if (warmup()) break;
+        }
+        if (!util.FinalizeT0Calibration()) {
+            std::cerr << "Not enough T0 reference hits to calibrate." << std::endl;
+            return 1;
+        }
+    }
+
+    auto fillCard = [&](int card, const CardSums& sums, double t0_avg, int pid_code) {
+        double tof = sums.time_sum / sums.hits - t0_avg;
+        double tof_min = sums.min_time - t0_avg;
+
+        if (all_cards) {
+            int pid_slot = 0;
+            for (int p = 1; p < 4; ++p)
+                if (pid_code == kPIDCodes[p]) pid_slot = p;
+
+            CardAccumulator& acc = cards[card];
+            if (!acc.h_tof[0]) BookCard(acc, card);
+            acc.n++;
+            acc.tof_sum += tof;
+            acc.tof_sum2 += tof * tof;
+            acc.tof_min_sum += tof_min;
+            acc.qdc_sum += sums.qdc_sum;
+
+            acc.h_tof[0]->Fill(tof);
+            acc.h_tof_min[0]->Fill(tof_min);
+            acc.h_qdc[0]->Fill(sums.qdc_sum);
+            if (pid_slot > 0) {
+                acc.h_tof[pid_slot]->Fill(tof);
+                acc.h_tof_min[pid_slot]->Fill(tof_min);
+                acc.h_qdc[pid_slot]->Fill(sums.qdc_sum);
+            }
+            return;
+        }
+
+        double qdc_sum = sums.qdc_sum;
+        h_tof->Fill(tof);
+        h_qdc->Fill(qdc_sum);
+        h_qdc_vs_tof->Fill(tof, qdc_sum);
+        h_tof_min->Fill(tof_min);
+        h_qdc_min->Fill(qdc_sum);
+        h_qdc_vs_tof_min->Fill(tof_min, qdc_sum);
+
+        if (pid_names.count(pid_code)) {
+            h_tof_pid[pid_code]->Fill(tof);
+            h_qdc_pid[pid_code]->Fill(qdc_sum);
+            h_qdc_vs_tof_pid[pid_code]->Fill(tof, qdc_sum);
+            h_tof_pid_min[pid_code]->Fill(tof_min);
+            h_qdc_pid_min[pid_code]->Fill(qdc_sum);
+            h_qdc_vs_tof_pid_min[pid_code]->Fill(tof_min, qdc_sum);
+        }
+    };
+
+    // Applies the 3 sigma T0 cut (counted in the WCTE_Log summary) and fills
+    // the histograms for every buffered event
+    auto drain = [&]() {
+        for (size_t e = 0; e < buffer.Size(); ++e) {
+            size_t h = buffer.t0_begin(e);
+            std::optional<double> t0_avg = util.ComputeT0(buffer.t0_k.data() + h, buffer.t0_time.data() + h,
+                                                          buffer.t0_end[e] - h);
+            if (!t0_avg) continue;
+
+            for (size_t c = buffer.card_begin(e); c < buffer.card_end[e]; ++c)
+                fillCard(buffer.card[c], buffer.Sums(c), *t0_avg, buffer.pid[e]);
+        }
+        buffer.Clear();
+    };
+
+    Long64_t nEntries = WCTE_Progress::Limit(reader.GetEntries(), max_events);
+    WCTE_Progress progress("ToF", nEntries);
+    pid.WithPIDMethod([&](auto method) {
+        for (Long64_t i = 0; i < nEntries; ++i) {
+            reader.GetEntry(i);
+            progress.Add();
+            pid.SetRunID(reader.run_id);
+            pid.SetBeamlineData(reader.beamline_pmt_qdc_charges, reader.beamline_pmt_qdc_ids,
+                                reader.beamline_pmt_tdc_times, reader.beamline_pmt_tdc_ids);
+            bool calibrating = !util.IsCalibrated();
+
+            buffer.BeginEvent(pid.GetParticleID(method));
+            for (int j : reader.hit_index.Card(131)) {
+                int ch = (*reader.hit_pmt_channel_ids)[j];
+                double t = (*reader.hit_pmt_times)[j];
+                for (int k = 0; k < 4; ++k) {
+                    if (ch == t0_ch[k]) {
+                        buffer.AddT0Hit(k, t);
+                        break;
                     }
+                }
+            }
+
+            if (all_cards) {
+                int last_card = std::min(reader.hit_index.MaxCard(), kMaxMPMTCard);
+                for (int card = 0; card <= last_card; ++card) {
+                    CardSums sums = SumCard(reader, card);
+                    if (sums.hits > 0) buffer.AddCard(card, sums);
+                }
+            } else {
+                CardSums sums = SumCard(reader, selected_card);
+                if (sums.hits > 0) buffer.AddCard(selected_card, sums);
             }
+            buffer.EndEvent();
 
-            if (card == selected_card && t > 1000 && t < 5000) {
-                card_sum += t;
-                qdc_sum += q;
-                card_hits++;
-                if (t < min_time) min_time = t;
+            if (calibrating && !warmup()) {
+                if (!util.CalibrationFailed() && buffer.Size() < n_calibration_max_events) continue;
+                if (!util.FinalizeT0Calibration()) break;
             }
+            drain();
+        }
+    });
+
+    // Inputs shorter than the warm-up calibrate from what they have; a
+    // failed calibration (reported by WCTE_Utility) stops here
+    if (!util.IsCalibrated()) {
+        if (!util.FinalizeT0Calibration()) {
+            std::cerr << "Not enough T0 reference hits to calibrate." << std::endl;
+            return 1;
         }
+        drain();
+    }
+
+    progress.Finish();
+    WCTE_Log::PrintSummary();
+
+    output.AddMetric("entries_read", nEntries);
+    for (int i = 0; i < 4; ++i) {
+        output.Add(h_t0_ch[i]);
+        output.AddMetric(Form("t0_ch%d_mean", t0_ch[i]), util.GetT0Mean(i));
+        output.AddMetric(Form("t0_ch%d_sigma", t0_ch[i]), util.GetT0Sigma(i));
+    }
 
-        if (t0_hits == 4 && card_hits > 0) {
-            double t0_avg = t0_sum / 4.0;
-            double card_avg = card_sum / card_hits;
-            double tof = card_avg - t0_avg;
-            double tof_min = min_time - t0_avg;
-
-            h_tof->Fill(tof);
-            h_qdc->Fill(qdc_sum);
-            h_qdc_vs_tof->Fill(tof, qdc_sum);
-            h_tof_min->Fill(tof_min);
-            h_qdc_min->Fill(qdc_sum);
-            h_qdc_vs_tof_min->Fill(tof_min, qdc_sum);
-
-            if (pid_names.count(pid_code)) {
-                h_tof_pid[pid_code]->Fill(tof);
-                h_qdc_pid[pid_code]->Fill(qdc_sum);
-                h_qdc_vs_tof_pid[pid_code]->Fill(tof, qdc_sum);
-                h_tof_pid_min[pid_code]->Fill(tof_min);
-                h_qdc_pid_min[pid_code]->Fill(qdc_sum);
-                h_qdc_vs_tof_pid_min[pid_code]->Fill(tof_min, qdc_sum);
+    if (all_cards) {
+        // One bin per card; errors are the spread over events, not of the mean
+        const int n_cards = kMaxMPMTCard + 1;
+        TH1D* h_mean_tof = new TH1D("h_card_mean_tof", "Mean ToF per Card;Card ID;Mean ToF (ns)", n_cards, -0.5, n_cards - 0.5);
+        TH1D* h_mean_tof_min = new TH1D("h_card_mean_tof_min", "Mean Min-Time ToF per Card;Card ID;Mean ToF (ns)", n_cards, -0.5, n_cards - 0.5);
+        TH1D* h_mean_qdc = new TH1D("h_card_mean_qdc", "Mean QDC Sum per Card;Card ID;Mean QDC", n_cards, -0.5, n_cards - 0.5);
+        TH1D* h_events = new TH1D("h_card_events", "Events with Hits per Card;Card ID;Events", n_cards, -0.5, n_cards - 0.5);
+
+        for (int card = 0; card < n_cards; ++card) {
+            const CardAccumulator& acc = cards[card];
+            if (acc.n == 0) continue;
+            double mean = acc.tof_sum / acc.n;
+            double rms = std::sqrt(std::max(0.0, acc.tof_sum2 / acc.n - mean * mean));
+            h_mean_tof->SetBinContent(card + 1, mean);
+            h_mean_tof->SetBinError(card + 1, rms);
+            h_mean_tof_min->SetBinContent(card + 1, acc.tof_min_sum / acc.n);
+            h_mean_qdc->SetBinContent(card + 1, acc.qdc_sum / acc.n);
+            h_events->SetBinContent(card + 1, acc.n);
+
+            output.AddMetric(Form("card%d_events", card), acc.n);
+            output.AddMetric(Form("card%d_tof_mean", card), mean);
+            output.AddMetric(Form("card%d_tof_sigma", card), rms);
+            output.AddMetric(Form("card%d_tof_min_mean", card), acc.tof_min_sum / acc.n);
+            output.AddMetric(Form("card%d_qdc_mean", card), acc.qdc_sum / acc.n);
+
+            std::string dir = Form("card%d", card);
+            for (int p = 0; p < 4; ++p) {
+                output.Add(acc.h_tof[p], dir);
+                output.Add(acc.h_tof_min[p], dir);
+                output.Add(acc.h_qdc[p], dir);
             }
         }
+
+        output.Add(h_mean_tof);
+        output.Add(h_mean_tof_min);
+        output.Add(h_mean_qdc);
+        output.Add(h_events);
+        delete tree;
+        return output.Write() ? 0 : 1;
+    }
+
+    output.Add(h_selected_all);
+    for (TH1* h : {(TH1*)h_tof, (TH1*)h_qdc, (TH1*)h_qdc_vs_tof, (TH1*)h_tof_min, (TH1*)h_qdc_min, (TH1*)h_qdc_vs_tof_min})
+        output.Add(h);
+    output.AddMetric("events_selected", h_tof->GetEntries());
+    output.AddMetric("tof_mean", h_tof->GetMean());
+    output.AddMetric("tof_sigma", h_tof->GetStdDev());
+    output.AddMetric("qdc_mean", h_qdc->GetMean());
+    for (const auto& [pid_code, name] : pid_names) {
+        output.Add(h_tof_pid[pid_code]);
+        output.Add(h_tof_pid_min[pid_code]);
+        output.Add(h_qdc_pid[pid_code]);
+        output.Add(h_qdc_pid_min[pid_code]);
+        output.Add(h_qdc_vs_tof_pid[pid_code]);
+        output.Add(h_qdc_vs_tof_pid_min[pid_code]);
+        output.AddMetric(std::string(name.Data()) + "_events", h_tof_pid[pid_code]->GetEntries());
+        output.AddMetric(std::string(name.Data()) + "_tof_mean", h_tof_pid[pid_code]->GetMean());
+        output.AddMetric(std::string(name.Data()) + "_tof_sigma", h_tof_pid[pid_code]->GetStdDev());
+    }
+    if (!output.Write()) return 1;
+    if (!output.Has(WCTE_Output::kPDF)) {
+        delete tree;
+        return 0;
     }
 
     TCanvas* c = new TCanvas("c", "Plots", 800, 600);
@@ -236,6 +513,6 @@ int main(int argc, char* argv[]) {
     }
 
     c->Print(output_pdf + ")");
-    file->Close();
+    delete tree;
     return 0;
 }
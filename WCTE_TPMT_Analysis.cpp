@@ -2,6 +2,7 @@
 
 #include <TFile.h>
 #include <TTree.h>
+#include <TChain.h>
 #include <TCanvas.h>
 #include <TH1D.h>
 #include <TText.h>
@@ -13,49 +14,48 @@
 #include <vector>
 #include <map>
 #include <algorithm>
+#include "WCTE_EventReader.h"
+#include "WCTE_Progress.h"
+#include "WCTE_FastHist.h"
+#include "WCTE_Output.h"
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file>" << std::endl;
-        return 1;
-    }
-
-    std::string filename = argv[1];
-    TString base_name = gSystem->BaseName(filename.c_str());
-
-    // Extract run number from filename (expecting 'R####')
-    int run_number = 0;
-    size_t rpos = base_name.Index("R");
-    size_t spos = base_name.Index("S");
-    if (rpos != kNPOS && spos != kNPOS && spos > rpos) {
-        run_number = atoi(base_name.Data() + rpos + 1);
+    std::vector<std::string> inputs;
+    Long64_t max_events = -1;
+    unsigned output_mode = WCTE_Output::kPDF;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-events" && i + 1 < argc) {
+            max_events = std::stoll(argv[++i]);
+        } else if (arg == "--output-mode" && i + 1 < argc) {
+            if (!WCTE_Output::ParseMode(argv[++i], output_mode)) return 1;
+        } else {
+            inputs.push_back(arg);
+        }
     }
 
-    std::string output_pdf = Form("tpmt_analysis_plots_run%d.pdf", run_number);
-
-    TFile* file = TFile::Open(filename.c_str());
-    if (!file || file->IsZombie()) {
-        std::cerr << "Error opening BRB file: " << filename << std::endl;
+    if (inputs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <BRB ROOT file|glob> [more files...] [--max-events N] [--output-mode root|json|pdf]" << std::endl;
         return 1;
     }
 
-    TTree* tree = (TTree*)file->Get("WCTEReadoutWindows");
+    TString base_name = gSystem->BaseName(inputs.front().c_str());
+    if (inputs.size() > 1) base_name += Form(" (+%d more)", (int)inputs.size() - 1);
+
+    TChain* tree = WCTE_EventReader::MakeChain(inputs);
     if (!tree) {
-        std::cerr << "Tree 'WCTEReadoutWindows' not found!" << std::endl;
+        std::cerr << "Error opening BRB files." << std::endl;
         return 1;
     }
 
-    std::vector<int>* hit_card_ids = nullptr;
-    std::vector<int>* hit_channel_ids = nullptr;
-    std::vector<double>* hit_times = nullptr;
-    std::vector<float>* bl_tdc_times = nullptr;
-    std::vector<int>* bl_tdc_ids = nullptr;
+    WCTE_EventReader reader(tree, WCTE_EventReader::kHitPMT | WCTE_EventReader::kBeamline);
+
+    // Run number taken from the run_id branch of the first event
+    reader.GetEntry(0);
+    int run_number = reader.run_id;
 
-    tree->SetBranchAddress("hit_mpmt_card_ids", &hit_card_ids);
-    tree->SetBranchAddress("hit_pmt_channel_ids", &hit_channel_ids);
-    tree->SetBranchAddress("hit_pmt_times", &hit_times);
-    tree->SetBranchAddress("beamline_pmt_tdc_times", &bl_tdc_times);
-    tree->SetBranchAddress("beamline_pmt_tdc_ids", &bl_tdc_ids);
+    WCTE_Output output(Form("tpmt_analysis_plots_run%d", run_number), output_mode);
+    std::string output_pdf = output.GetBase() + ".pdf";
 
     const int hit_tdc_channels[4] = {12, 13, 14, 15};
     const int bl_tdc_channels[4] = {0, 1, 2, 3};
@@ -67,6 +67,11 @@ int main(int argc, char* argv[]) {
     TH1D* h_bl_t0_avg = new TH1D("h_bl_t0_avg", "T0 Avg from Beamline;TDC Time (ns);Counts", 200, 0, 100);
     std::map<int, TH1D*> h_card_timing;
 
+    // Per-card hit times are filled per hit, so they are counted in FastHists
+    // (one slot per mPMT card) and turned into TH1Ds after the loop
+    const FastAxis card_time_axis(5000, 0, 5000);
+    std::vector<FastHist1D> card_timing;
+
     for (int i = 0; i < 4; ++i) {
         h_hit_tdc[i] = new TH1D(Form("h_hit_tdc_ch%d", hit_tdc_channels[i]),
                                 Form("Hit PMT - Card 131 Ch %d (%s)", hit_tdc_channels[i], ch_names[i]),
@@ -79,40 +84,39 @@ int main(int argc, char* argv[]) {
     TGraph* g_peak = new TGraph();
     int point = 0;
 
-    Long64_t nEntries = std::min(tree->GetEntries(), (Long64_t)5000);
+    Long64_t nEntries = WCTE_Progress::Limit(reader.GetEntries(), max_events);
+    WCTE_Progress progress("TPMT", nEntries);
     for (Long64_t i = 0; i < nEntries; ++i) {
-        tree->GetEntry(i);
+        reader.GetEntry(i);
+        progress.Add();
         double sum_hit = 0, sum_bl = 0;
         int count_hit = 0, count_bl = 0;
 
-        for (size_t j = 0; j < hit_card_ids->size(); ++j) {
-            int card = (*hit_card_ids)[j];
-            int ch = (*hit_channel_ids)[j];
-            double t = (*hit_times)[j];
-
-            if (card == 131) {
-                for (int k = 0; k < 4; ++k) {
-                    if (ch == hit_tdc_channels[k]) {
-                        h_hit_tdc[k]->Fill(t);
-                        if (t > 2150 && t < 2250) {
-                            sum_hit += t;
-                            ++count_hit;
-                        }
+        for (int j : reader.hit_index.Card(131)) {
+            int ch = (*reader.hit_pmt_channel_ids)[j];
+            double t = (*reader.hit_pmt_times)[j];
+            for (int k = 0; k < 4; ++k) {
+                if (ch == hit_tdc_channels[k]) {
+                    h_hit_tdc[k]->Fill(t);
+                    if (t > 2150 && t < 2250) {
+                        sum_hit += t;
+                        ++count_hit;
                     }
                 }
             }
+        }
 
-            if (card < 130) {
-                if (!h_card_timing.count(card)) {
-                    h_card_timing[card] = new TH1D(Form("h_card_%d", card), Form("Hit Time Card %d;Time (ns);Counts", card), 5000, 0, 5000);
-                }
-                h_card_timing[card]->Fill(t);
-            }
+        // Cards below 130 are the mPMTs
+        int last_card = std::min(reader.hit_index.MaxCard(), 129);
+        if (last_card >= (int)card_timing.size()) card_timing.resize(last_card + 1, FastHist1D(card_time_axis));
+        for (int card = 0; card <= last_card; ++card) {
+            FastHist1D& hist = card_timing[card];
+            for (int j : reader.hit_index.Card(card)) hist.Fill((*reader.hit_pmt_times)[j]);
         }
 
-        for (size_t j = 0; j < bl_tdc_ids->size(); ++j) {
-            int ch = (*bl_tdc_ids)[j];
-            float t = (*bl_tdc_times)[j];
+        for (size_t j = 0; j < reader.beamline_pmt_tdc_ids->size(); ++j) {
+            int ch = (*reader.beamline_pmt_tdc_ids)[j];
+            float t = (*reader.beamline_pmt_tdc_times)[j];
             for (int k = 0; k < 4; ++k) {
                 if (ch == bl_tdc_channels[k]) {
                     h_bl_tdc[k]->Fill(t);
@@ -128,10 +132,37 @@ int main(int argc, char* argv[]) {
         if (count_bl == 4) h_bl_t0_avg->Fill(sum_bl / 4.0);
     }
 
+    progress.Finish();
+
+    for (size_t card = 0; card < card_timing.size(); ++card) {
+        if (card_timing[card].GetEntries() == 0) continue;
+        h_card_timing[card] = card_timing[card].ToTH1D(Form("h_card_%d", (int)card),
+                                                       Form("Hit Time Card %d;Time (ns);Counts", (int)card));
+    }
+
     for (const auto& [card, hist] : h_card_timing) {
         int max_bin = hist->GetMaximumBin();
         double peak = hist->GetXaxis()->GetBinCenter(max_bin);
         g_peak->SetPoint(point++, card, peak);
+        output.Add(hist, "cards");
+        output.AddMetric(Form("card%d_peak_time", card), peak);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        output.Add(h_hit_tdc[i]);
+        output.Add(h_bl_tdc[i]);
+    }
+    output.Add(h_hit_t0_avg);
+    output.Add(h_bl_t0_avg);
+    output.AddMetric("entries_read", nEntries);
+    output.AddMetric("hit_t0_avg_mean", h_hit_t0_avg->GetMean());
+    output.AddMetric("hit_t0_avg_sigma", h_hit_t0_avg->GetStdDev());
+    output.AddMetric("beamline_t0_avg_mean", h_bl_t0_avg->GetMean());
+    output.AddMetric("beamline_t0_avg_sigma", h_bl_t0_avg->GetStdDev());
+    if (!output.Write()) return 1;
+    if (!output.Has(WCTE_Output::kPDF)) {
+        delete tree;
+        return 0;
     }
 
     TCanvas* c = new TCanvas("c", "TPMT Analysis", 1000, 800);
@@ -182,6 +213,6 @@ int main(int argc, char* argv[]) {
     g_peak->Draw("AP");
     c->Print((output_pdf + ")").c_str());
 
-    file->Close();
+    delete tree;
     return 0;
 }
@@ -1,99 +1,154 @@
 #include "WCTE_Utility.h"
-#include <TTree.h>      // ← This is required
-#include <TH1D.h>
-#include <TF1.h>
-#include <TMath.h>
+#include "WCTE_Log.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+namespace {
+
+WCTE_LogReason t0_hit_outside("T0 hit outside 3 sigma");
+WCTE_LogReason t0_event_incomplete("Event without 4 valid T0 hits");
+
+// Mean and sigma of the core of a peak: start from the median and the MAD,
+// then iterate the mean/RMS of the values within 3 sigma until stable. The
+// RMS of a normal distribution truncated at +-3 sigma is 1.36% low, which
+// is corrected so the sigma matches a Gaussian fit.
+bool truncatedMeanSigma(std::vector<double>& v, double& mean, double& sigma) {
+    if (v.size() < 10) return false;
+
+    size_t mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + mid, v.end());
+    mean = v[mid];
+    std::vector<double> dev(v.size());
+    for (size_t i = 0; i < v.size(); ++i) dev[i] = std::abs(v[i] - mean);
+    std::nth_element(dev.begin(), dev.begin() + mid, dev.end());
+    sigma = 1.4826 * dev[mid];
+    if (sigma <= 0) return false;
+
+    const double kWindow = 3.0;
+    const double kTruncationCorrection = 1.0136;
+    for (int iter = 0; iter < 20; ++iter) {
+        double sum = 0, sum2 = 0;
+        size_t n = 0;
+        for (double x : v) {
+            if (std::abs(x - mean) >= kWindow * sigma) continue;
+            sum += x;
+            sum2 += x * x;
+            ++n;
+        }
+        if (n < 2) return false;
+        double m = sum / n;
+        double s = std::sqrt(std::max(0.0, sum2 / n - m * m)) * kTruncationCorrection;
+        bool converged = std::abs(m - mean) < 1e-4 && std::abs(s - sigma) < 1e-4;
+        mean = m;
+        sigma = s;
+        if (converged) break;
+    }
+    return sigma > 0;
+}
+
+} // namespace
 
 WCTE_Utility::WCTE_Utility() {}
 
 void WCTE_Utility::SetHitPMTData(const std::vector<int>* card_ids,
                                  const std::vector<int>* channel_ids,
-                                 const std::vector<double>* times) {
+                                 const std::vector<double>* times,
+                                 const WCTE_HitIndex* index) {
     card_ids_ = card_ids;
     channel_ids_ = channel_ids;
     times_ = times;
+    index_ = index;
 }
 
-void WCTE_Utility::InitializeT0Calibration(TTree* tree, size_t n_events) {
-    if (!tree || !card_ids_ || !channel_ids_ || !times_) return;
+template <class F>
+void WCTE_Utility::forEachT0Hit(F&& f) const {
+    auto visit = [&](size_t j) {
+        int ch = (*channel_ids_)[j];
+        for (int k = 0; k < 4; ++k) {
+            if (ch == t0_channels_[k]) {
+                f(k, (*times_)[j]);
+                break;
+            }
+        }
+    };
 
-    std::vector<TH1D*> hists(4);
-    for (int i = 0; i < 4; ++i) {
-        hists[i] = new TH1D(Form("h_t0_ch%d", t0_channels_[i]),
-                            Form("T0 Channel %d", t0_channels_[i]),
-                            200, 2150, 2250);
+    if (index_) {
+        for (int j : index_->Card(target_card_)) visit(j);
+        return;
     }
+    for (size_t j = 0; j < card_ids_->size(); ++j) {
+        if ((*card_ids_)[j] == target_card_) visit(j);
+    }
+}
 
-    size_t nEntries = std::min((size_t)tree->GetEntries(), n_events);
-    for (size_t i = 0; i < nEntries; ++i) {
-        tree->GetEntry(i);
-        for (size_t j = 0; j < card_ids_->size(); ++j) {
-            if ((*card_ids_)[j] != target_card_) continue;
-
-            int ch = (*channel_ids_)[j];
-            double t = (*times_)[j];
+bool WCTE_Utility::AddCalibrationHits() {
+    if (initialized_) return true;
+    if (failed_) return false;
+    if (!card_ids_ || !channel_ids_ || !times_) return false;
 
-            for (int k = 0; k < 4; ++k) {
-                if (ch == t0_channels_[k] && t > 2150 && t < 2250) {
-                    hists[k]->Fill(t);
-                    break;
-                }
-            }
-        }
-    }
+    forEachT0Hit([this](int k, double t) {
+        if (t > 2150 && t < 2250 && warmup_[k].size() < calibration_hits_) warmup_[k].push_back(t);
+    });
 
     for (int k = 0; k < 4; ++k) {
-        TH1D* h = hists[k];
-        double peak = h->GetXaxis()->GetBinCenter(h->GetMaximumBin());
-        TF1* fit = new TF1(Form("fit_ch%d", t0_channels_[k]), "gaus", peak - 8, peak + 8);
-        fit->SetParameters(h->GetMaximum(), peak, 4.0);
-        h->Fit(fit, "RQ");
+        if (warmup_[k].size() < calibration_hits_) return false;
+    }
+    return FinalizeT0Calibration();
+}
 
-        t0_mean_[k] = fit->GetParameter(1);
-        t0_sigma_[k] = fit->GetParameter(2);
+bool WCTE_Utility::FinalizeT0Calibration() {
+    if (initialized_) return true;
+    if (failed_) return false;
 
-        delete fit;
-        delete h;
+    // A failure is final: it is reported once and the warm-up is released,
+    // so callers polling per event neither re-sort it nor print again
+    for (int k = 0; k < 4; ++k) {
+        if (!truncatedMeanSigma(warmup_[k], t0_mean_[k], t0_sigma_[k])) {
+            std::cerr << "T0 calibration failed for card " << target_card_ << " channel " << t0_channels_[k]
+                      << " (" << warmup_[k].size() << " hits)" << std::endl;
+            failed_ = true;
+            break;
+        }
     }
 
-    initialized_ = true;
+    for (int k = 0; k < 4; ++k) std::vector<double>().swap(warmup_[k]);
+    initialized_ = !failed_;
+    return initialized_;
 }
 
-std::optional<double> WCTE_Utility::ComputeEventT0() const {
-    if (!card_ids_ || !channel_ids_ || !times_) return std::nullopt;
-
+template <class H>
+std::optional<double> WCTE_Utility::averageT0(H&& forEachHit) const {
     double sum = 0.0;
     int count = 0;
 
-    for (size_t i = 0; i < card_ids_->size(); ++i) {
-        int card = (*card_ids_)[i];
-        int ch   = (*channel_ids_)[i];
-        double t = (*times_)[i];
-
-        if (card != target_card_) continue;
+    forEachHit([&](int k, double t) {
+        double mean  = t0_mean_[k];
+        double sigma = t0_sigma_[k];
 
-        for (int k = 0; k < 4; ++k) {
-            if (ch == t0_channels_[k]) {
-                double mean  = t0_mean_[k];   // Corrected
-                double sigma = t0_sigma_[k];  // Corrected
-
-                if (std::abs(t - mean) < 3 * sigma) {
-                    sum += t;
-                    ++count;
-                } else {
-                    std::cout << "[DEBUG] Rejecting hit: ch=" << ch
-                              << " t=" << t << " outside 3σ from mean=" << mean
-                              << ", σ=" << sigma << std::endl;
-                }
-                break;
-            }
+        if (std::abs(t - mean) < 3 * sigma) {
+            sum += t;
+            ++count;
+        } else {
+            WCTE_LOG_EXAMPLE(t0_hit_outside, "ch=" << t0_channels_[k] << " t=" << t
+                             << " mean=" << mean << " sigma=" << sigma);
         }
-    }
+    });
 
     if (count == 4) return sum / 4.0;
 
-    std::cout << "[DEBUG] Skipped event: only " << count << " valid T0 hits" << std::endl;
+    WCTE_LOG_EXAMPLE(t0_event_incomplete, "only " << count << " valid T0 hits");
     return std::nullopt;
 }
+
+std::optional<double> WCTE_Utility::ComputeEventT0() const {
+    if (!initialized_ || !card_ids_ || !channel_ids_ || !times_) return std::nullopt;
+    return averageT0([this](auto&& f) { forEachT0Hit(f); });
+}
+
+std::optional<double> WCTE_Utility::ComputeT0(const int8_t* k, const double* t, size_t n) const {
+    if (!initialized_) return std::nullopt;
+    return averageT0([&](auto&& f) {
+        for (size_t i = 0; i < n; ++i) f(k[i], t[i]);
+    });
+}
@@ -3,34 +3,63 @@
 
 #include <vector>
 #include <optional>
-#include <numeric> 
-#include <TTree.h>      // ← This is required
-#include <TH1D.h>
-#include <TF1.h>
-#include <TMath.h>
-
+#include <cstddef>
+#include <cstdint>
+#include "WCTE_HitIndex.h"
 
 class WCTE_Utility {
 public:
     WCTE_Utility();
 
+    // With a hit index for the same event (e.g. WCTE_EventReader::hit_index)
+    // only the hits on the T0 card are visited
     void SetHitPMTData(const std::vector<int>* card_ids,
                        const std::vector<int>* channel_ids,
-                       const std::vector<double>* times);
+                       const std::vector<double>* times,
+                       const WCTE_HitIndex* index = nullptr);
+
+    // Streaming T0 calibration, fed from the main event loop: call
+    // AddCalibrationHits() after each SetHitPMTData() until it returns true
+    // (every T0 channel has collected n_hits warm-up hits in 2150-2250 ns).
+    // FinalizeT0Calibration() fixes the calibration early from what was
+    // collected, e.g. when the input is short. If the fit of a channel fails
+    // (too few hits, zero spread) the calibration is marked failed; both
+    // calls then return false at once, without another attempt.
+    void SetCalibrationHits(size_t n_hits) { calibration_hits_ = n_hits; }
+    bool AddCalibrationHits();
+    bool FinalizeT0Calibration();
+    bool IsCalibrated() const { return initialized_; }
+    bool CalibrationFailed() const { return failed_; }
+
+    double GetT0Mean(int k) const { return t0_mean_[k]; }
+    double GetT0Sigma(int k) const { return t0_sigma_[k]; }
 
-    void InitializeT0Calibration(TTree* tree, size_t n_events);
     std::optional<double> ComputeEventT0() const;  // Computes per-event average T0 using stored cuts
 
+    // Same cut and counters for T0 hits kept outside the event, e.g. buffered
+    // during the warm-up: k[i] is the T0 channel slot (0-3) of time t[i]
+    std::optional<double> ComputeT0(const int8_t* k, const double* t, size_t n) const;
+
 private:
     const std::vector<int>* card_ids_ = nullptr;
     const std::vector<int>* channel_ids_ = nullptr;
     const std::vector<double>* times_ = nullptr;
+    const WCTE_HitIndex* index_ = nullptr;
 
     static constexpr int target_card_ = 131;
     static constexpr int t0_channels_[4] = {12, 13, 14, 15};
     double t0_mean_[4] = {0};
     double t0_sigma_[4] = {0};
     bool initialized_ = false;
+    bool failed_ = false;
+
+    template <class F>
+    void forEachT0Hit(F&& f) const;  // f(k, t) for hits on the T0 channels
+    template <class H>
+    std::optional<double> averageT0(H&& forEachHit) const;  // 3 sigma cut, 4 hits
+
+    size_t calibration_hits_ = 2000;       // warm-up hits per channel
+    std::vector<double> warmup_[4];        // bounded by calibration_hits_
 };
 
 #endif
@@ -0,0 +1,47 @@
+#include "WCTE_VMEReader.h"
+#include <algorithm>
+
+WCTE_VMEReader::WCTE_VMEReader(TTree* tree)
+    : tdc_offsets(kChannels + 1, 0), tree_(tree) {
+    qdc_charges.reserve(kChannels);
+    qdc_ids.reserve(kChannels);
+    qdc_raw.reserve(kChannels);
+    if (!tree_) return;
+    tree_->SetBranchAddress("beamline_qdc_charge", &qdc_);
+    tree_->SetBranchAddress("beamline_tdc_time", &tdc_);
+}
+
+int WCTE_VMEReader::GetEntry(Long64_t entry) {
+    int bytes = tree_ ? tree_->GetEntry(entry) : 0;
+    decode();
+    return bytes;
+}
+
+void WCTE_VMEReader::decode() {
+    qdc_charges.clear();
+    qdc_ids.clear();
+    qdc_raw.clear();
+    if (qdc_) {
+        int n = std::min<int>(qdc_->size(), kChannels);
+        for (int ch = 0; ch < n; ++ch) {
+            qdc_charges.push_back((float)(*qdc_)[ch]);
+            qdc_ids.push_back(ch);
+            qdc_raw.push_back((*qdc_)[ch]);
+        }
+    }
+
+    tdc_times.clear();
+    tdc_ids.clear();
+    tdc_raw.clear();
+    int n = tdc_ ? std::min<int>(tdc_->size(), kChannels) : 0;
+    for (int ch = 0; ch < kChannels; ++ch) {
+        tdc_offsets[ch] = (int)tdc_times.size();
+        if (ch >= n) continue;
+        for (double t : (*tdc_)[ch]) {
+            tdc_times.push_back((float)(t + kTDCOffset));
+            tdc_ids.push_back(ch);
+            tdc_raw.push_back(t);
+        }
+    }
+    tdc_offsets[kChannels] = (int)tdc_times.size();
+}
@@ -0,0 +1,80 @@
+#ifndef WCTE_VMEREADER_H
+#define WCTE_VMEREADER_H
+
+#include <vector>
+#include <TTree.h>
+
+// Reader for the VME beam_monitor_calib tree that presents each event in
+// the BRB beamline layout, so WCTE_BeamMon_PID and the BRB code paths run
+// on VME data unchanged:
+//   qdc_charges / qdc_ids  one QDC per channel (beamline_qdc_charge)
+//   tdc_times / tdc_ids    every TDC hit, shifted by kTDCOffset to the BRB
+//                          time base, grouped by channel
+// tdc_offsets holds kChannels + 1 entries: the hits of channel ch are
+// tdc_times[tdc_offsets[ch] .. tdc_offsets[ch + 1]). qdc_raw and tdc_raw
+// hold the same values in the VME's double precision, without the offset;
+// cuts defined on VME times (e.g. T0/T1 below -100 ns) use these, since the
+// float BRB view rounds once on the shift and again when the PID code takes
+// the 250 ns back off, which can move a hit across the cut. The flat buffers are
+// reused from event to event, and ROOT keeps reading the nested TDC vector
+// into the same object, so decoding allocates nothing once capacities have
+// grown.
+class WCTE_VMEReader {
+public:
+    static constexpr int kChannels = 64;
+    static constexpr double kTDCOffset = 250.0;  // VME TDC + 250 ns = BRB beamline_pmt_tdc_times
+
+    // Hits of one channel in tdc_times (Range) or tdc_raw (RawRange)
+    template <class T>
+    class BasicRange {
+    public:
+        BasicRange(const T* b, const T* e) : begin_(b), end_(e) {}
+        const T* begin() const { return begin_; }
+        const T* end() const { return end_; }
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+    private:
+        const T* begin_;
+        const T* end_;
+    };
+    using Range = BasicRange<float>;
+    using RawRange = BasicRange<double>;
+
+    explicit WCTE_VMEReader(TTree* tree);
+
+    TTree* GetTree() const { return tree_; }
+    Long64_t GetEntries() const { return tree_ ? tree_->GetEntries() : 0; }
+
+    // Reads and decodes one entry; returns the bytes read like TTree::GetEntry
+    int GetEntry(Long64_t entry);
+
+    Range TDC(int ch) const {
+        if (ch < 0 || ch >= kChannels) return Range(nullptr, nullptr);
+        return Range(tdc_times.data() + tdc_offsets[ch], tdc_times.data() + tdc_offsets[ch + 1]);
+    }
+
+    RawRange RawTDC(int ch) const {
+        if (ch < 0 || ch >= kChannels) return RawRange(nullptr, nullptr);
+        return RawRange(tdc_raw.data() + tdc_offsets[ch], tdc_raw.data() + tdc_offsets[ch + 1]);
+    }
+
+    // BRB-style views of the current event
+    std::vector<float> qdc_charges;
+    std::vector<int>   qdc_ids;
+    std::vector<float> tdc_times;
+    std::vector<int>   tdc_ids;
+    std::vector<int>   tdc_offsets;
+
+    // Double-precision VME values, parallel to qdc_charges / tdc_times
+    std::vector<double> qdc_raw;
+    std::vector<double> tdc_raw;
+
+private:
+    void decode();
+
+    TTree* tree_ = nullptr;
+    std::vector<double>* qdc_ = nullptr;
+    std::vector<std::vector<double>>* tdc_ = nullptr;
+};
+
+#endif